@@ -0,0 +1,113 @@
+#include "alloc.hpp"
+
+#ifndef _WIN32
+    #include <cstdlib>
+    #include <new>
+#endif
+
+std::atomic<unsigned long long> allocation_count(0);
+std::atomic<unsigned long long> allocation_bytes(0);
+
+bool allocation_tracking(){
+#ifdef DASHER_TRACK_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+Allocation_Counts allocation_counts(){
+    return {allocation_count.load(std::memory_order_relaxed), allocation_bytes.load(std::memory_order_relaxed)};
+}
+
+Allocation_Tracker::Allocation_Tracker():
+    n_scopes(0),
+    frame_start{0, 0}{}
+
+void Allocation_Tracker::begin_frame(){
+    for(int i = 0; i < n_scopes; i++)
+        scopes[i].counts = {0, 0};
+    frame_start = allocation_counts();
+}
+
+Allocation_Counts Allocation_Tracker::frame() const{
+    Allocation_Counts now = allocation_counts();
+    return {now.allocations - frame_start.allocations, now.bytes - frame_start.bytes};
+}
+
+//Scope names are string literals, so the same scope always comes back with the same pointer.
+void Allocation_Tracker::add(const char* name, Allocation_Counts counts){
+    int i = 0;
+    while(i < n_scopes && scopes[i].name != name)
+        i++;
+    if(i == n_scopes){
+        if(n_scopes == max_scopes) return;
+        scopes[n_scopes++] = {name, {0, 0}};
+    }
+    scopes[i].counts.allocations += counts.allocations;
+    scopes[i].counts.bytes += counts.bytes;
+}
+
+Allocation_Tracker& allocation_tracker(){
+    static Allocation_Tracker instance;
+    return instance;
+}
+
+Alloc_Scope::Alloc_Scope(const char* name):
+    name(name),
+    start(allocation_counts()){}
+
+Alloc_Scope::~Alloc_Scope(){
+    Allocation_Counts now = allocation_counts();
+    allocation_tracker().add(name, {now.allocations - start.allocations, now.bytes - start.bytes});
+}
+
+#ifdef DASHER_TRACK_ALLOCATIONS
+
+void* operator new(std::size_t size){
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    allocation_bytes.fetch_add(size, std::memory_order_relaxed);
+    if(void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size){
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept{
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    allocation_bytes.fetch_add(size, std::memory_order_relaxed);
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept{
+    return operator new(size, tag);
+}
+
+void operator delete(void* p) noexcept{
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept{
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept{
+    std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept{
+    std::free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept{
+    std::free(p);
+}
+
+#endif
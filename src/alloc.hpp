@@ -0,0 +1,56 @@
+#pragma once
+
+#ifndef _WIN32
+    #include <atomic>
+#endif
+
+//Counting global operator new and delete, installed when DASHER_TRACK_ALLOCATIONS is defined
+//(cmake -DDASHER_TRACK_ALLOCATIONS=ON). Without it every count stays at zero and ALLOC_SCOPE compiles to nothing.
+struct Allocation_Counts{
+    unsigned long long allocations;
+    unsigned long long bytes;
+};
+
+extern std::atomic<unsigned long long> allocation_count;
+extern std::atomic<unsigned long long> allocation_bytes;
+
+bool allocation_tracking();
+Allocation_Counts allocation_counts();
+
+//Totals of the current frame, overall and per named scope. Scopes nest, so an allocation is counted
+//in every scope it happens under. The table is fixed so that keeping it never allocates.
+struct Allocation_Tracker{
+    struct Scope_Total{
+        const char* name;
+        Allocation_Counts counts;
+    };
+
+    static const int max_scopes = 32;
+    Scope_Total scopes[max_scopes];
+    int n_scopes;
+    Allocation_Counts frame_start;
+
+    Allocation_Tracker();
+
+    void begin_frame();
+    Allocation_Counts frame() const;
+    void add(const char* name, Allocation_Counts counts);
+};
+
+Allocation_Tracker& allocation_tracker();
+
+struct Alloc_Scope{
+    const char* name;
+    Allocation_Counts start;
+
+    Alloc_Scope(const char* name);
+    ~Alloc_Scope();
+};
+
+#ifdef DASHER_TRACK_ALLOCATIONS
+    #define ALLOC_CONCAT_(a, b) a##b
+    #define ALLOC_CONCAT(a, b) ALLOC_CONCAT_(a, b)
+    #define ALLOC_SCOPE(name) Alloc_Scope ALLOC_CONCAT(alloc_scope_, __LINE__)(name)
+#else
+    #define ALLOC_SCOPE(name)
+#endif
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "defaults.hpp"
+#include <SFML/Graphics/Rect.hpp>
+
+//Animations share one clock, the simulation time kept by Timer_Wheel. Something animated only stores the time
+//its animation started: its frame is the number of periods gone by since, wrapped around the frames of a row.
+constexpr unsigned animation_frame(float now, float start, float period, unsigned frames){
+    return now > start ? unsigned((now - start) / period) % frames : 0;
+}
+
+//The rects of a sheet of rows by columns sprites of the same size, built at compile time.
+template <unsigned columns, unsigned rows>
+struct Frame_Table{
+    sf::IntRect rects[rows][columns];
+
+    constexpr const sf::IntRect& operator()(unsigned row, unsigned column) const{
+        return rects[row][column];
+    }
+};
+
+template <unsigned columns, unsigned rows>
+constexpr Frame_Table<columns, rows> frame_table(sf::Vector2i size){
+    Frame_Table<columns, rows> table{};
+    for(unsigned row = 0; row < rows; row++)
+        for(unsigned column = 0; column < columns; column++)
+            table.rects[row][column] = sf::IntRect({int(column) * size.x, int(row) * size.y}, size);
+    return table;
+}
+
+//The player sheet has a row per direction standing still, then the same four directions moving.
+constexpr Frame_Table<h_sheet, v_sheet> player_frames = frame_table<h_sheet, v_sheet>(player_sprite_size);
+constexpr Frame_Table<h_sheet, 1> ghost_frames = frame_table<h_sheet, 1>(ghost_sprite_size);
+constexpr Frame_Table<h_sheet, 1> heart_frames = frame_table<h_sheet, 1>(heart_sprite_size);
+
+static_assert(player_frames(7, 3) == sf::IntRect({3 * player_sprite_size.x, 7 * player_sprite_size.y}, player_sprite_size),
+              "player frames follow the sheet layout");
@@ -0,0 +1,53 @@
+#include "arena.hpp"
+#include "defaults.hpp"
+
+#ifndef _WIN32
+    #include <charconv>
+    #include <cstdint>
+    #include <new>
+#endif
+
+Frame_Arena::Frame_Arena(size_t capacity):
+    buffer(new unsigned char[capacity]),
+    capacity(capacity),
+    used(0),
+    peak(0),
+    overflow(0){}
+
+void* Frame_Arena::allocate(size_t bytes, size_t alignment){
+    std::uintptr_t base = reinterpret_cast<std::uintptr_t>(buffer.get());
+    size_t start = (base + used + alignment - 1) / alignment * alignment - base;
+    if(start + bytes > capacity){
+        overflow++;
+        return ::operator new(bytes);
+    }
+    used = start + bytes;
+    if(used > peak)
+        peak = used;
+    return buffer.get() + start;
+}
+
+void Frame_Arena::deallocate(void* p){
+    if(!owns(p))
+        ::operator delete(p);
+}
+
+bool Frame_Arena::owns(const void* p) const{
+    const unsigned char* c = static_cast<const unsigned char*>(p);
+    return c >= buffer.get() && c < buffer.get() + capacity;
+}
+
+void Frame_Arena::reset(){
+    used = 0;
+}
+
+Frame_Arena& frame_arena(){
+    static Frame_Arena arena(frame_arena_capacity);
+    return arena;
+}
+
+void append_number(Frame_String& text, unsigned long long n){
+    char digits[24];
+    std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), n);
+    text.append(digits, result.ptr);
+}
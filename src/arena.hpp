@@ -0,0 +1,62 @@
+#pragma once
+
+#ifndef _WIN32
+    #include <cstddef>
+    #include <memory>
+    #include <string>
+    #include <vector>
+#endif
+
+//Bump allocator for what only lives until the end of a frame. reset() at the top of the main loop hands
+//the whole buffer back at once, and deallocating is a no-op. A request that does not fit goes to the
+//global heap and is counted in overflow, so running short costs speed, never correctness.
+//Only the main thread uses it.
+struct Frame_Arena{
+    std::unique_ptr<unsigned char[]> buffer;
+    size_t capacity;
+    size_t used;
+    size_t peak;
+    unsigned long long overflow;
+
+    Frame_Arena(size_t capacity);
+
+    void* allocate(size_t bytes, size_t alignment);
+    void deallocate(void* p);
+    bool owns(const void* p) const;
+    void reset();
+};
+
+Frame_Arena& frame_arena();
+
+//Standard allocator on top of frame_arena(), for containers that must not outlive the frame.
+template <typename T>
+struct Frame_Allocator{
+    typedef T value_type;
+
+    Frame_Allocator() = default;
+    template <typename U>
+    Frame_Allocator(const Frame_Allocator<U>&){}
+
+    T* allocate(size_t n){
+        return static_cast<T*>(frame_arena().allocate(n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T* p, size_t){
+        frame_arena().deallocate(p);
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const Frame_Allocator<T>&, const Frame_Allocator<U>&){
+    return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const Frame_Allocator<T>&, const Frame_Allocator<U>&){
+    return false;
+}
+
+template <typename T>
+using Frame_Vector = std::vector<T, Frame_Allocator<T>>;
+typedef std::basic_string<char, std::char_traits<char>, Frame_Allocator<char>> Frame_String;
+
+void append_number(Frame_String& text, unsigned long long n);
@@ -0,0 +1,36 @@
+#include "batch.hpp"
+
+Sprite_Batch::Sprite_Batch(const sf::Texture& texture):
+    texture(&texture),
+    vertices(sf::PrimitiveType::Triangles){}
+
+void Sprite_Batch::clear(){
+    vertices.clear();
+}
+
+//Same placement as an sf::Sprite with that origin, scale and texture rect, without rotation.
+void Sprite_Batch::add(sf::Vector2f position, sf::Vector2f origin, sf::Vector2f scale, sf::IntRect rect){
+    sf::Vector2f size(rect.size);
+    sf::Vector2f top_left(position.x - origin.x * scale.x, position.y - origin.y * scale.y);
+    sf::Vector2f bottom_right(top_left.x + size.x * scale.x, top_left.y + size.y * scale.y);
+    sf::Vector2f tex_top_left(rect.position);
+    sf::Vector2f tex_bottom_right = tex_top_left + size;
+
+    sf::Vertex corners[4] = {
+        {top_left, sf::Color::White, tex_top_left},
+        {{bottom_right.x, top_left.y}, sf::Color::White, {tex_bottom_right.x, tex_top_left.y}},
+        {{top_left.x, bottom_right.y}, sf::Color::White, {tex_top_left.x, tex_bottom_right.y}},
+        {bottom_right, sf::Color::White, tex_bottom_right}
+    };
+    vertices.append(corners[0]);
+    vertices.append(corners[1]);
+    vertices.append(corners[2]);
+    vertices.append(corners[2]);
+    vertices.append(corners[1]);
+    vertices.append(corners[3]);
+}
+
+void Sprite_Batch::draw(sf::RenderTarget& target) const{
+    if(vertices.getVertexCount() == 0) return;
+    target.draw(vertices, sf::RenderStates(texture));
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+
+//Collects every sprite sharing a texture into one vertex array, two triangles per sprite,
+//and submits them with a single draw call. Cleared and refilled every frame.
+struct Sprite_Batch{
+    const sf::Texture* texture;
+    sf::VertexArray vertices;
+
+    Sprite_Batch(const sf::Texture& texture);
+
+    void clear();
+    void add(sf::Vector2f position, sf::Vector2f origin, sf::Vector2f scale, sf::IntRect rect);
+    void draw(sf::RenderTarget& target) const;
+};
@@ -0,0 +1,287 @@
+#include "entities.hpp"
+#include "kernels.hpp"
+#include "jobs.hpp"
+#include "animation.hpp"
+#include "arena.hpp"
+#include "defaults.hpp"
+
+#ifndef _WIN32
+    #include <chrono>
+    #include <fstream>
+    #include <iomanip>
+    #include <iostream>
+    #include <string>
+    #include <vector>
+#endif
+
+//Micro-benchmarks for the geometry helpers and the entity kernels. Every benchmark runs one operation over
+//a fixed number of items, repeated until min_time has passed, and reports the time per item as ns/op.
+struct Options{
+    std::string json = "bench.json";
+    std::string filter;
+    double min_time = 0.2;
+};
+
+struct Result{
+    std::string name;
+    size_t items;
+    unsigned long long iterations;
+    double ns_per_op;
+    double items_per_second;
+};
+
+//Results are folded into a volatile so the compiler cannot drop the work being measured.
+volatile float sink;
+
+void usage(const char* name){
+    std::cerr << "usage: " << name << " [--json path] [--filter text] [--min-time seconds]\n"
+              << "  --json      where to write the results (default bench.json)\n"
+              << "  --filter    only run the benchmarks whose name contains text\n"
+              << "  --min-time  time spent on each benchmark (default 0.2)\n";
+}
+
+bool parse(int argc, char** argv, Options& options){
+    for(int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        if(i + 1 >= argc)
+            return false;
+        try{
+            if(arg == "--json")
+                options.json = argv[++i];
+            else if(arg == "--filter")
+                options.filter = argv[++i];
+            else if(arg == "--min-time")
+                options.min_time = std::stod(argv[++i]);
+            else
+                return false;
+        }
+        catch(...){
+            return false;
+        }
+    }
+    return options.min_time > 0;
+}
+
+struct Bench{
+    Options options;
+    std::vector<Result> results;
+
+    //op processes items items per call. The iteration count doubles until a batch lasts min_time.
+    template <typename Op>
+    void run(const std::string& name, size_t items, Op op){
+        if(name.find(options.filter) == std::string::npos) return;
+
+        typedef std::chrono::steady_clock clock;
+        op();
+        unsigned long long iterations = 1;
+        double elapsed = 0;
+        while(true){
+            clock::time_point start = clock::now();
+            for(unsigned long long i = 0; i < iterations; i++)
+                op();
+            elapsed = std::chrono::duration<double>(clock::now() - start).count();
+            if(elapsed >= options.min_time) break;
+            iterations *= 2;
+        }
+
+        double total = double(iterations) * items;
+        Result result{name, items, iterations, elapsed * 1e9 / total, total / elapsed};
+        std::cout << std::left << std::setw(40) << name << std::right
+                  << std::setw(12) << std::fixed << std::setprecision(2) << result.ns_per_op << " ns/op"
+                  << std::setw(16) << std::setprecision(0) << result.items_per_second << " items/s\n";
+        results.push_back(result);
+    }
+
+    bool write_json() const{
+        std::ofstream file(options.json, std::ios::out | std::ios::trunc);
+        if(!file)
+            return false;
+        file << "{\"benchmarks\":[";
+        for(size_t i = 0; i < results.size(); i++){
+            const Result& r = results[i];
+            file << (i ? ",\n" : "\n")
+                 << "{\"name\":\"" << r.name << "\",\"items\":" << r.items << ",\"iterations\":" << r.iterations
+                 << ",\"ns_per_op\":" << r.ns_per_op << ",\"items_per_second\":" << r.items_per_second << "}";
+        }
+        file << "\n]}\n";
+        return bool(file);
+    }
+};
+
+//Points spread over the arena, the same for every run.
+std::vector<sf::Vector2f> scatter(size_t n){
+    Random random(0, 3);
+    std::vector<sf::Vector2f> points(n);
+    for(sf::Vector2f& p: points)
+        p = sf::Vector2f(random.below(window_width), random.below(window_height));
+    return points;
+}
+
+void bench_geometry(Bench& bench){
+    const size_t n = 1024;
+    std::vector<sf::Vector2f> points = scatter(n);
+    sf::Vector2f center(window_width / 2, window_height / 2);
+
+    bench.run("dist", n, [&]{
+        float sum = 0;
+        for(sf::Vector2f p: points)
+            sum += dist(p, center);
+        sink = sum;
+    });
+    bench.run("angle", n, [&]{
+        float sum = 0;
+        for(sf::Vector2f p: points)
+            sum += angle(p, center).asRadians();
+        sink = sum;
+    });
+    bench.run("edge_intersects", n, [&]{
+        int hits = 0;
+        for(size_t i = 0; i + 1 < n; i++)
+            hits += edge_intersects(center, points[i], points[i + 1], points[(i + 7) % n]);
+        sink = hits;
+    });
+}
+
+void bench_ghosts(Bench& bench){
+    const size_t n = 1024;
+    std::vector<sf::Vector2f> points = scatter(n);
+    bool directions[4] = {false, false, false, false};
+    Timer_Wheel timers(timer_capacity);
+    Player player(directions, &timers);
+    const Ghost_Archetype& archetype = ghost_archetypes[basic_ghost];
+    player.attack = true;
+    player.aftr.position = player.position + sf::Vector2f(400, 150);
+
+    bench.run("ghost_hurt", n, [&]{
+        int hits = 0;
+        for(sf::Vector2f p: points)
+            hits += ghost_hurt(p, archetype, player);
+        sink = hits;
+    });
+
+    std::vector<float> x(n), y(n);
+    std::vector<unsigned char> hit(n);
+    for(size_t i = 0; i < n; i++){
+        x[i] = points[i].x;
+        y[i] = points[i].y;
+    }
+    bench.run("segment_hits_boxes", n, [&]{
+        segment_hits_boxes(player.position, player.aftr.position, archetype.half_size, x.data(), y.data(), n, hit.data());
+        sink = hit[n / 2];
+    });
+    bench.run("segment_hits_boxes_scalar", n, [&]{
+        segment_hits_boxes_scalar(player.position, player.aftr.position, archetype.half_size, x.data(), y.data(), n, hit.data());
+        sink = hit[n / 2];
+    });
+
+    //Steering moves the points: each run starts again from the scattered positions.
+    std::vector<float> prev_x(n), prev_y(n);
+    std::vector<unsigned char> kind(n, basic_ghost);
+    float speeds[1] = {archetype.speed};
+    bench.run("steer_towards", n, [&]{
+        for(size_t i = 0; i < n; i++){
+            x[i] = points[i].x;
+            y[i] = points[i].y;
+        }
+        steer_towards(player.position, speeds, kind.data(), simulation_period, x.data(), y.data(), prev_x.data(), prev_y.data(), n);
+        sink = x[n / 2];
+    });
+    bench.run("steer_towards_scalar", n, [&]{
+        for(size_t i = 0; i < n; i++){
+            x[i] = points[i].x;
+            y[i] = points[i].y;
+        }
+        steer_towards_scalar(player.position, speeds, kind.data(), simulation_period, x.data(), y.data(), prev_x.data(), prev_y.data(), n);
+        sink = x[n / 2];
+    });
+}
+
+//What drawing costs per animated sprite: the frame from the shared clock, then its rect from the table.
+void bench_animation(Bench& bench){
+    const size_t n = 1024;
+    std::vector<float> starts(n);
+    for(size_t i = 0; i < n; i++)
+        starts[i] = i * simulation_period;
+    float now = 1000;
+
+    bench.run("animation_frame", n, [&]{
+        unsigned sum = 0;
+        for(float start: starts)
+            sum += animation_frame(now, start, animation_fps_period, h_sheet);
+        sink = sum;
+        now += simulation_period;
+    });
+    bench.run("player_frames", n, [&]{
+        int sum = 0;
+        for(size_t i = 0; i < n; i++)
+            sum += player_frames(i & 7, animation_frame(now, starts[i], animation_fps_period, h_sheet)).position.x;
+        sink = sum;
+    });
+}
+
+//The same HUD style string built on the global heap and in the frame arena, one frame per iteration.
+void bench_arena(Bench& bench){
+    const size_t n = 64;
+
+    bench.run("string/heap", n, [&]{
+        size_t sum = 0;
+        for(size_t i = 0; i < n; i++){
+            std::string text = "allocations/frame: " + std::to_string(i) + " (" + std::to_string(i * 64) + " bytes)";
+            sum += text.size();
+        }
+        sink = sum;
+    });
+    bench.run("string/arena", n, [&]{
+        frame_arena().reset();
+        size_t sum = 0;
+        for(size_t i = 0; i < n; i++){
+            Frame_String text("allocations/frame: ");
+            append_number(text, i);
+            text += " (";
+            append_number(text, i * 64);
+            text += " bytes)";
+            sum += text.size();
+        }
+        sink = sum;
+    });
+}
+
+//Ghosts spawn on the usual ring and drift toward the player while the benchmark runs,
+//less than a hundred pixels at the largest size. The jobs variants spread the chunks over every hardware thread.
+void bench_horde(Bench& bench){
+    Job_System jobs(default_workers());
+    for(bool parallel: {false, true})
+        for(size_t n: {10, 100, 1000, 10000, 100000}){
+            Simulation sim(0);
+            sim.horde.reserve(n);
+            for(size_t i = 0; i < n; i++)
+                sim.horde.spawn_ghost();
+            sim.player.invulnerable = true;
+            if(parallel)
+                sim.horde.jobs = &jobs;
+
+            bench.run("Horde::update_horde/" + std::to_string(n) + (parallel ? "/jobs" : ""), n, [&]{
+                sim.horde.update_horde(simulation_period);
+                sink = sim.horde.ghosts.column<Position_X>()[0];
+            });
+        }
+}
+
+int main(int argc, char** argv){
+    Bench bench;
+    if(!parse(argc, argv, bench.options)){
+        usage(argv[0]);
+        return 1;
+    }
+
+    bench_geometry(bench);
+    bench_ghosts(bench);
+    bench_animation(bench);
+    bench_arena(bench);
+    bench_horde(bench);
+
+    if(!bench.write_json()){
+        std::cerr << "could not write " << bench.options.json << "\n";
+        return 1;
+    }
+}
@@ -1,5 +1,24 @@
-#include "entities.hpp"
-//#include "defaults.hpp"
+#include "state.hpp"
+#include "defaults.hpp"
+#include "profiler.hpp"
+#include "alloc.hpp"
+#include "arena.hpp"
+
+#ifndef _WIN32
+    #include <algorithm>
+    #include <iostream>
+    #include <random>
+    #include <string>
+#endif
+
+//Writes what was recorded since the last dump and starts over, so every F9 gives the frames since the previous one.
+void write_trace(){
+    if(profiler().write_chrome_trace(trace_path))
+        std::cout << "trace written to " << trace_path << std::endl;
+    else
+        std::cerr << "could not write " << trace_path << std::endl;
+    profiler().clear();
+}
 
 void handle_close (sf::RenderWindow& window){
     window.close();
@@ -20,43 +39,49 @@ void handle_resize (const sf::Event::Resized& resized, sf::RenderWindow& window)
 void handle(const sf::Event::KeyPressed &KeyPressed, State &state){
     switch(KeyPressed.code){
         case sf::Keyboard::Key::W:
-            state.directions[3] = true;
+            state.sim.directions[3] = true;
             break;
         case sf::Keyboard::Key::A:
-            state.directions[1] = true;
+            state.sim.directions[1] = true;
             break;
         case sf::Keyboard::Key::S:
-            state.directions[2] = true;
+            state.sim.directions[2] = true;
             break;
         case sf::Keyboard::Key::D:
-            state.directions[0] = true;
+            state.sim.directions[0] = true;
             break;
     }
 
     if(KeyPressed.code == sf::Keyboard::Key::LShift)
-        state.player.start_dash();
+        state.sim.player.start_dash();
     if(KeyPressed.code == sf::Keyboard::Key::Space)
         state.restart();
+#ifdef DASHER_PROFILE
+    if(KeyPressed.code == sf::Keyboard::Key::F9)
+        write_trace();
+#endif
+    if(KeyPressed.code == sf::Keyboard::Key::F3 && allocation_tracking())
+        state.hud.show_debug = !state.hud.show_debug;
 }
 
 void handle(const sf::Event::KeyReleased &KeyReleased, State &state){
     switch(KeyReleased.code){
         case sf::Keyboard::Key::W:
-            state.directions[3] = false;
+            state.sim.directions[3] = false;
             break;
         case sf::Keyboard::Key::A:
-            state.directions[1] = false;
+            state.sim.directions[1] = false;
             break;
         case sf::Keyboard::Key::S:
-            state.directions[2] = false;
+            state.sim.directions[2] = false;
             break;
         case sf::Keyboard::Key::D:
-            state.directions[0] = false;
+            state.sim.directions[0] = false;
             break;
     }
 
     if(KeyReleased.code == sf::Keyboard::Key::LShift)
-        state.player.stop_dash();
+        state.sim.player.stop_dash();
 }
 
 void handle(const sf::Event::FocusGained, State &state){
@@ -70,26 +95,77 @@ void handle(const sf::Event::FocusLost, State &state){
 template <typename T>
 void handle(const T& event, State& state){}
 
-int main(){
+//A run can be replayed by passing back the seed printed at startup: dasher --seed <n>
+std::uint64_t parse_seed(int argc, char** argv){
+    for(int i = 1; i + 1 < argc; i++)
+        if(std::string(argv[i]) == "--seed")
+            try{
+                return std::stoull(argv[i + 1]);
+            }
+            catch(...){}
+    std::random_device device;
+    return (std::uint64_t(device()) << 32) | device();
+}
+
+//Frames whose work takes longer than this many milliseconds get written out by the flight recorder: dasher --budget <ms>
+float parse_budget(int argc, char** argv){
+    for(int i = 1; i + 1 < argc; i++)
+        if(std::string(argv[i]) == "--budget")
+            try{
+                return std::stof(argv[i + 1]) / 1000;
+            }
+            catch(...){}
+    return frame_budget;
+}
+
+int main(int argc, char** argv){
+    std::uint64_t seed = parse_seed(argc, argv);
+    std::cout << "seed: " << seed << std::endl;
+
     //sf::ContextSettings settings;
     //settings.antiAliasingLevel = 16;
     sf::RenderWindow window(sf::VideoMode ({1280, 720}), "Dasher");
     window.setVerticalSyncEnabled(true);
     //window.setFramerateLimit(1);
 
-    State state;
+    State state(seed);
+    state.recorder.budget = parse_budget(argc, argv);
     sf::Clock delta;
+    sf::Clock frame;
+    float accumulator = 0;
     sf::Color bg(sf::Color::Black);
 
     while (window.isOpen()){
-        window.handleEvents([&window](const sf::Event::Closed&){handle_close(window);},
-                            [&window](const sf::Event::Resized& event){handle_resize(event, window);},
-                            [&state] (const auto& event){handle(event, state);});
-
-        bg = (state.update(delta.restart().asSeconds()))? sf::Color::White: sf::Color::Black;
+        PROFILE_SCOPE("frame");
+        frame_arena().reset();
+        state.hud.set_allocations(allocation_tracker().frame());
+        allocation_tracker().begin_frame();
+        {
+            PROFILE_SCOPE("events");
+            ALLOC_SCOPE("events");
+            window.handleEvents([&window](const sf::Event::Closed&){handle_close(window);},
+                                [&window](const sf::Event::Resized& event){handle_resize(event, window);},
+                                [&state] (const auto& event){handle(event, state);});
+        }
+
+        //The simulation always advances in simulation_period steps, whatever the display rate is.
+        accumulator += std::min(delta.restart().asSeconds(), max_frame_time);
+        while(accumulator >= simulation_period){
+            bg = (state.update(simulation_period))? sf::Color::White: sf::Color::Black;
+            accumulator -= simulation_period;
+        }
 
         window.clear(bg);
-        state.draw(window);
-        window.display();
+        state.draw(window, accumulator / simulation_period);
+        float work = frame.restart().asSeconds();
+        {
+            PROFILE_SCOPE("display");
+            window.display();
+        }
+        state.recorder.end_frame(work, frame.restart().asSeconds());
     }
+
+#ifdef DASHER_PROFILE
+    write_trace();
+#endif
 }
\ No newline at end of file
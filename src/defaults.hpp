@@ -1,41 +1,62 @@
+#pragma once
+
 #include <SFML/System.hpp>
 
 #ifdef _WIN32
-    const char* player_sheet = "../../../resources/full_sheet_outlined_3.png";
-    const char* ghost_sheet = "../../../resources/ghost sheet outlined-white.png";
-    const char* heart_sprite = "../../../resources/heart.png";
-    const char* font_path = "../../../resources/Silkscreen-Regular.ttf";
-    const char* animated_heart = "../../../resources/heartsheet.png";
-    const char* background = "../../../resources/tilesettop.png";
-    const char* gameover_path = "../../../resources/gameover.png";
-    const char* ost_path = "../../../resources/Battle.ogg";
-    const char* defeat_path = "../../../resources/Main.ogg";
-    const char* hit_path = "../../../resources/Hit.wav";
-    const char* pick_path = "../../../resources/Pickup.wav";
-    const char* player_hit_path = "../../../resources/SuperHit.wav";
+    const char* const player_sheet = "../../../resources/full_sheet_outlined_3.png";
+    const char* const ghost_sheet = "../../../resources/ghost sheet outlined-white.png";
+    const char* const heart_sprite = "../../../resources/heart.png";
+    const char* const font_path = "../../../resources/Silkscreen-Regular.ttf";
+    const char* const animated_heart = "../../../resources/heartsheet.png";
+    const char* const background = "../../../resources/tilesettop.png";
+    const char* const gameover_path = "../../../resources/gameover.png";
+    const char* const ost_path = "../../../resources/Battle.ogg";
+    const char* const defeat_path = "../../../resources/Main.ogg";
+    const char* const hit_path = "../../../resources/Hit.wav";
+    const char* const pick_path = "../../../resources/Pickup.wav";
+    const char* const player_hit_path = "../../../resources/SuperHit.wav";
 #else
-    const char* player_sheet = "../../resources/full_sheet_outlined_3.png";
-    const char* ghost_sheet = "../../resources/ghost sheet outlined-white.png";
-    const char* heart_sprite = "../../resources/heart.png";
-    const char* font_path = "../../resources/Silkscreen-Regular.ttf";
-    const char* animated_heart = "../../resources/heartsheet.png";
-    const char* background = "../../resources/tilesettop.png";
-    const char* gameover_path = "../../resources/gameover.png";
-    const char* ost_path = "../../resources/Battle.ogg";
-    const char* defeat_path = "../../resources/Main.ogg";
-    const char* hit_path = "../../resources/Hit.wav";
-    const char* pick_path = "../../resources/Pickup.wav";
-    const char* player_hit_path = "../../resources/SuperHit.wav";
+    const char* const player_sheet = "../../resources/full_sheet_outlined_3.png";
+    const char* const ghost_sheet = "../../resources/ghost sheet outlined-white.png";
+    const char* const heart_sprite = "../../resources/heart.png";
+    const char* const font_path = "../../resources/Silkscreen-Regular.ttf";
+    const char* const animated_heart = "../../resources/heartsheet.png";
+    const char* const background = "../../resources/tilesettop.png";
+    const char* const gameover_path = "../../resources/gameover.png";
+    const char* const ost_path = "../../resources/Battle.ogg";
+    const char* const defeat_path = "../../resources/Main.ogg";
+    const char* const hit_path = "../../resources/Hit.wav";
+    const char* const pick_path = "../../resources/Pickup.wav";
+    const char* const player_hit_path = "../../resources/SuperHit.wav";
 #endif
 
+const char* const trace_path = "trace.json";
+const char* const flight_prefix = "flight";
+
 const unsigned window_width = 1280;
 const unsigned window_height = 720;
 const sf::Vector2f player_scale = {5, 5};
 const unsigned h_sheet = 4;
 const unsigned v_sheet = 8;
-const sf::Vector2i player_sprite_size = {14, 15};
-const sf::Vector2i ghost_sprite_size = {19, 21};
-const sf::Vector2i heart_sprite_size = {16, 16};
+constexpr sf::Vector2i player_sprite_size = {14, 15};
+constexpr sf::Vector2i ghost_sprite_size = {19, 21};
+constexpr sf::Vector2i heart_sprite_size = {16, 16};
 const float player_speed = 500;
+const float ghost_speed = 100;
 const float animation_fps_period = 1.0/5.0;
+const float simulation_period = 1.0/120.0;
+const float max_frame_time = 0.25;
+const float grid_cell_size = 128;
+const unsigned horde_capacity = 1024;
+const float tree_margin = 16;
+const unsigned flight_capacity = 1 << 14;
+const float frame_budget = 0.008;
+const float flight_window = 5;
+const float flight_post_window = 0.5;
+const float tree_prediction = 1.0;
+const unsigned horde_chunk = 1024;
+const float invulnerability_period = 1.5;
+const float fail_period = 1;
+const unsigned timer_capacity = 64;
+const unsigned frame_arena_capacity = 1 << 16;
 const float volume = 25;
\ No newline at end of file
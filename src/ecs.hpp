@@ -0,0 +1,99 @@
+#pragma once
+
+#include "handles.hpp"
+
+#ifndef _WIN32
+    #include <cstddef>
+    #include <tuple>
+    #include <type_traits>
+    #include <utility>
+    #include <vector>
+#endif
+
+//A component is a tag type naming a column, with the value the column stores as its type member.
+//Position is two components, x and y, so the kernels get the plain float arrays they vectorize over.
+template <typename C, typename First, typename... Rest>
+constexpr size_t component_index(){
+    if constexpr(std::is_same_v<C, First>)
+        return 0;
+    else
+        return 1 + component_index<C, Rest...>();
+}
+
+//Every entity of an archetype lives in its table, one packed column per component, so a system runs down
+//the columns it needs as arrays. Rows are removed with swap-and-pop and named by the table's handles.
+//Fixed capacity like the other pools: push refuses a row once the table is full.
+template <typename... Components>
+struct Archetype{
+    size_t capacity = 0;
+    std::tuple<std::vector<typename Components::type>...> columns;
+    Handle_Registry handles;
+
+    template <typename C>
+    static constexpr bool has(){
+        return (std::is_same_v<C, Components> || ...);
+    }
+
+    template <typename C>
+    std::vector<typename C::type>& column(){
+        return std::get<component_index<C, Components...>()>(columns);
+    }
+
+    template <typename C>
+    const std::vector<typename C::type>& column() const{
+        return std::get<component_index<C, Components...>()>(columns);
+    }
+
+    size_t size() const{
+        return std::get<0>(columns).size();
+    }
+
+    bool empty() const{
+        return size() == 0;
+    }
+
+    //Values come in the order of Components. Returns a null handle when the table is full.
+    Handle push(const typename Components::type&... values){
+        if(size() >= capacity)
+            return Handle();
+        (column<Components>().push_back(values), ...);
+        return handles.create();
+    }
+
+    void remove(size_t i){
+        handles.remove(i);
+        (remove_row(column<Components>(), i), ...);
+    }
+
+    void clear(){
+        (column<Components>().clear(), ...);
+        handles.clear();
+    }
+
+    //Only ever grows the table.
+    void reserve(size_t n){
+        if(n <= capacity) return;
+        capacity = n;
+        (column<Components>().reserve(n), ...);
+        handles.reserve(n);
+    }
+
+    template <typename T>
+    static void remove_row(std::vector<T>& values, size_t i){
+        values[i] = values.back();
+        values.pop_back();
+    }
+};
+
+//Calls system(table) on every table that has all of Components, or on every table when none are given.
+//Which tables match is settled at compile time, so a query is as cheap as calling the system by hand.
+template <typename... Components, typename... Tables, typename System>
+void for_each_table(std::tuple<Tables&...> tables, System&& system){
+    std::apply([&system](Tables&... table){
+        auto visit = [&system](auto& t){
+            if constexpr((std::decay_t<decltype(t)>::template has<Components>() && ...))
+                system(t);
+        };
+        (visit(table), ...);
+    }, tables);
+}
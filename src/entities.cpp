@@ -1,7 +1,11 @@
 #include "entities.hpp"
 #include "defaults.hpp"
+#include "profiler.hpp"
+#include "alloc.hpp"
+#include "animation.hpp"
 
 #ifndef _WIN32
+    #include <algorithm>
     #include <cmath>
 #endif
 
@@ -13,6 +17,10 @@ sf::Angle angle(sf::Vector2f p1, sf::Vector2f p2){
     return sf::radians(atan2(p2.y - p1.y, p2.x - p1.x));
 }
 
+sf::Vector2f lerp(sf::Vector2f p1, sf::Vector2f p2, float t){
+    return p1 + (p2 - p1) * t;
+}
+
 bool edge_intersects(const sf::Vector2f& a, const sf::Vector2f& b, const sf::Vector2f& c, const sf::Vector2f& d) {
     float det = (b.x - a.x) * (d.y - c.y) - (b.y - a.y) * (d.x - c.x);
     if (det == 0) return false;
@@ -23,57 +31,43 @@ bool edge_intersects(const sf::Vector2f& a, const sf::Vector2f& b, const sf::Vec
     return (t >= 0 && t <= 1 && u >= 0 && u <= 1);
 }
 
-Entity::Entity(sf::Vector2f position, sf::Vector2f origin, const sf::Vector2i sprite_size, const sf::Vector2f scale, const float animation_period, const unsigned n_frames, unsigned sprite_direction, sf::Texture& texture):
-    position(position),
-    origin(origin),
-    sprite_size(sprite_size),
-    scale(scale),
-    size(sf::Vector2f(sprite_size.x * scale.x, sprite_size.y * scale.y)),
-    sprite(texture),
-    anim(animation_period, n_frames, sprite_size),
-    sprite_direction(sprite_direction),
-    moving(false){
-        sprite.setOrigin(origin);
-        sprite.setScale(scale);
-}
-
-bool Entity::update(float delta){
-    return anim.update(delta);
+Random::Random(std::uint64_t seed, std::uint64_t stream):
+    state(0),
+    inc((stream << 1) | 1){
+        next();
+        state += seed;
+        next();
 }
 
-void Entity::draw(sf::RenderWindow& window){
-    sprite.setPosition(position);
-    sprite.setTextureRect(anim.get_sprite(sprite_direction, moving));
-
-    window.draw(sprite);
+std::uint32_t Random::next(){
+    std::uint64_t old = state;
+    state = old * 6364136223846793005ULL + inc;
+    std::uint32_t xorshifted = ((old >> 18) ^ old) >> 27;
+    std::uint32_t rot = old >> 59;
+    return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
 }
 
-Animation_Updater::Animation_Updater(float period, unsigned max, sf::Vector2i sprite_size):
-        time_elapsed(0),
-        progression(0),
-        period(period),
-        max(max),
-        sprite_size(sprite_size){}
-
-bool Animation_Updater::update(float delta){
-    time_elapsed += delta;
-    if(time_elapsed >= period){
-        time_elapsed -= period;
-        progression = (progression + 1) % max;
-        return true;
+//Unbiased: values below the threshold would make the low results more likely, so they are redrawn.
+std::uint32_t Random::below(std::uint32_t bound){
+    std::uint32_t threshold = -bound % bound;
+    while(true){
+        std::uint32_t r = next();
+        if(r >= threshold)
+            return r % bound;
     }
-    return false;
-}
-
-void Animation_Updater::draw(sf::RenderWindow &window){}
-
-sf::IntRect Animation_Updater::get_sprite(int direction, bool moving){
-    return sf::IntRect({{progression * sprite_size.x, (direction + moving * 4) * sprite_size.y}, sprite_size});
 }
 
 //Player::Player(){}
-Player::Player(bool directions[4], sf::Texture& texture, sf::SoundBuffer& hit_buffer):
-    Entity(sf::Vector2f(window_width / 2, window_height / 2), sf::Vector2f(player_sprite_size.x / 2, player_sprite_size.y / 2), player_sprite_size, player_scale, animation_fps_period, h_sheet, 2, texture),
+Player::Player(bool directions[4], Timer_Wheel* timers):
+    position(window_width / 2, window_height / 2),
+    origin(player_sprite_size.x / 2, player_sprite_size.y / 2),
+    sprite_size(player_sprite_size),
+    scale(player_scale),
+    size(sprite_size.x * scale.x, sprite_size.y * scale.y),
+    anim_start(0),
+    sprite_direction(2),
+    moving(false),
+    prev_position(position),
     speed(player_speed),
     dashing(false),
     invulnerable(false),
@@ -82,22 +76,22 @@ Player::Player(bool directions[4], sf::Texture& texture, sf::SoundBuffer& hit_bu
     prev_attack(false),
     success(false),
     fail(false),
+    hurt(false),
     health(3),
-    inv_window(0),
-    fail_window(0),
     directions(directions),
-    aftr(origin, scale, texture),
     screen_size(window_width, window_height),
-    hit_sound(hit_buffer){
-        hit_sound.setVolume(volume);
-}
+    timers(timers),
+    inv_timer(-1),
+    fail_timer(-1){}
 
 //void Player::update(float delta){}
 bool Player::update(float delta){
+    PROFILE_SCOPE("Player::update");
+    ALLOC_SCOPE("Player::update");
+    hurt = false;
+    prev_position = position;
     if(dead) return true;
 
-    Entity::update(delta);
-
     sf::Vector2f movement(directions[0] - directions[1], directions[2] - directions[3]);
     if(movement.length() != 0)
         movement = movement.normalized();
@@ -118,38 +112,9 @@ bool Player::update(float delta){
         moving = true;
     else if(movement.length() == 0 && moving == true)
         moving = false;
-
-    if(invulnerable){
-        inv_window += delta;
-        if(inv_window >= 1.5){
-            inv_window = 0;
-            invulnerable = false;
-            sprite.setColor(sf::Color::White);
-        }
-    }
-
-    if(fail){
-        fail_window += delta;
-        if(fail_window >= 1){
-            fail_window = 0;
-            fail = false;
-        }
-    }
     return false;
 }
 
-void Player::draw(sf::RenderWindow& window){
-    if(dashing){
-        draw_line(window);
-        aftr.draw(window);
-    }
-
-    if(fail && !dead)
-        draw_fail_bar(window);
-
-    Entity::draw(window);
-}
-
 void Player::calculate_direction(sf::Vector2f vec){
     unsigned tmp = sprite_direction;
     if(vec.x > 0)
@@ -169,7 +134,7 @@ void Player::start_dash(){
     if(dashing || dead || fail || attack) return;
 
     dashing = true;
-    aftr.set_start(anim.get_sprite(sprite_direction, moving), position, sprite_direction);
+    aftr.set_start(sprite_rect(), position, sprite_direction);
 }
 
 void Player::stop_dash(){
@@ -179,16 +144,6 @@ void Player::stop_dash(){
     attack = true;
 }
 
-void Player::draw_line(sf::RenderWindow& window){
-    sf::RectangleShape line({dist(position, aftr.position), scale.x});
-    line.setFillColor(sf::Color::White);
-    line.setOrigin({0, scale.x / 2});
-    line.setPosition(position);
-    line.setRotation(angle(position, aftr.position));
-
-    window.draw(line);
-}
-
 void Player::move_and_collide(sf::Vector2f movement, float delta){
     if(position.x >= screen_size.x - (sprite_size.x / 2 * scale.x) - 20 && movement.x > 0)
         movement.x = 0;
@@ -205,31 +160,28 @@ void Player::move_and_collide(sf::Vector2f movement, float delta){
 void Player::hit(){
     if(invulnerable) return;
 
-    hit_sound.play();
+    hurt = true;
 
-    if(--health == 0){
+    if(--health == 0)
         dead = true;
-        //sprite.setColor(sf::Color(127,127,127));
-        sprite.setRotation(sf::degrees(90));
-    }
-    else
-        sprite.setColor(sf::Color::Red);
-    
+
     if(dashing){
         dashing = false;
-        fail = true;
+        start_fail();
     }
     invulnerable = true;
+    inv_timer = timers->schedule(invulnerability_period, Timer_Kind::Invulnerability);
 }
 
 void Player::successful_dash(){
     if(success){
         success = false;
         position = aftr.position;
+        prev_position = position;
         sprite_direction = aftr.sprite_direction;
     }
     else
-        fail = true;
+        start_fail();
 }
 
 void Player::heal(){
@@ -237,161 +189,321 @@ void Player::heal(){
         health++;
 }
 
-void Player::draw_fail_bar(sf::RenderWindow& window){
-    sf::RectangleShape ext({150, 20});
-    ext.setOrigin({75,0});
-    ext.setFillColor(sf::Color::Black);
-    ext.setOutlineThickness(-5);
-    ext.setOutlineColor(sf::Color::White);
-    ext.setPosition(position + sf::Vector2f(0, 100));
-    window.draw(ext);
-
-    sf::RectangleShape ent({(150 * fail_window), 20});
-    ent.setOrigin({75,0});
-    ent.setFillColor(sf::Color::White);
-    ent.setPosition(position + sf::Vector2f(0, 100));
-    window.draw(ent);
+//Invulnerability and the fail window end when their timer fires, see Simulation::fire.
+void Player::start_fail(){
+    if(fail) return;
+    fail = true;
+    fail_timer = timers->schedule(fail_period, Timer_Kind::Dash_Fail);
 }
 
-//After_Image::After_Image(){}
-After_Image::After_Image(sf::Vector2f origin, sf::Vector2f size, sf::Texture& texture):
-    sprite(texture),
-    sprite_direction(0){
-        sprite.setScale(size);
-        sprite.setOrigin(origin);
-        //sprite.setColor(sf::Color(127, 127, 127));
+//The player animates from the start of the game. The clock stops with the simulation once the player is dead.
+sf::IntRect Player::sprite_rect() const{
+    return player_frames(sprite_direction + moving * 4, animation_frame(timers->time(), anim_start, animation_fps_period, h_sheet));
 }
 
-bool After_Image::update(float delta){return false;}
-
-void After_Image::draw(sf::RenderWindow& window){
-    window.draw(sprite);
+//How much of the fail window has gone by, from 0 to 1.
+float Player::fail_progress() const{
+    if(!fail) return 0;
+    return 1 - timers->remaining(fail_timer) / fail_period;
 }
 
+//After_Image::After_Image(){}
+After_Image::After_Image():
+    sprite_direction(0){}
+
 void After_Image::set_start(sf::IntRect rect, sf::Vector2f position, unsigned sprite_direction){
-    sprite.setTextureRect(rect);
+    this->rect = rect;
     this->position = position;
-    sprite.setPosition(position);
     this->sprite_direction = sprite_direction;
 }
 
-//Ghost::Ghost(){}
-Ghost::Ghost(sf::Vector2f position,Player* player, sf::Texture& texture):
-    Entity(position, sf::Vector2f(ghost_sprite_size.x / 2, ghost_sprite_size.y / 2), ghost_sprite_size, player_scale, animation_fps_period, h_sheet, 0, texture),
-    speed(100),
-    player(player){}
-
-//void Ghost::update(float delta){}
-bool Ghost::update(float delta){
-    Entity::update(delta);
+//The hit box keeps the integer halving of the sprite size the game has always used.
+const Ghost_Archetype ghost_archetypes[n_ghost_archetypes] = {
+    {
+        ghost_sprite_size,
+        ghost_frames.rects[0],
+        sf::Vector2f(ghost_sprite_size.x / 2, ghost_sprite_size.y / 2),
+        player_scale,
+        sf::Vector2f(ghost_sprite_size.x / 2 * player_scale.x, ghost_sprite_size.y / 2 * player_scale.y),
+        ghost_speed,
+        animation_fps_period,
+        h_sheet
+    }
+};
 
-    position += sf::Vector2f(speed, angle(position, player->position)) * delta;
+bool Event_Queue::push(Event_Kind kind, Handle target){
+    if(events.size() >= capacity){
+        overflow++;
+        return false;
+    }
+    events.push_back({kind, target});
+    return true;
+}
 
-    if(player_hit(player->position))
-        player->hit();
+void Event_Queue::clear(){
+    events.clear();
+}
 
-    if(player_hurt()){
-        player->success = true;
-        return true;
-    }
+void Event_Queue::reserve(size_t n){
+    if(n > capacity)
+        capacity = n;
+    events.reserve(capacity);
+}
 
-    return false;
+float ghost_contact_radius(const Ghost_Archetype& archetype, const Player& player){
+    return archetype.scale.x * archetype.sprite_size.x / 2 + player.scale.x * player.sprite_size.x / 2 - 10;
 }
 
-void Ghost::draw(sf::RenderWindow& window){
-    Entity::draw(window);
+bool ghost_hit(sf::Vector2f position, const Ghost_Archetype& archetype, const Player& player){
+    return dist(position, player.position) < ghost_contact_radius(archetype, player);
 }
 
-bool Ghost::player_hit(sf::Vector2f p_position){
-    /*return (((position.x + (size.x / 2 * scale.x)) >= (p.position.x - (p.size.x / 2 * p.scale.x))) &&
-            ((position.x - (size.x / 2 * scale.x)) <= (p.position.x + (p.size.x / 2 * p.scale.x))) &&
-            ((position.y + (size.y / 2 * scale.y)) >= (p.position.y - (p.size.y / 2 * p.scale.y))) &&
-            ((position.y - (size.y / 2 * scale.y)) <= (p.position.y + (p.size.y / 2 * p.scale.y))));*/
-    return dist(position, p_position) < scale.x * sprite_size.x / 2 + player->scale.x * player->sprite_size.x / 2 - 10;
+bool ghost_hurt(sf::Vector2f position, const Ghost_Archetype& archetype, const Player& player){
+    if(!player.attack) return false;
+    Aabb box = ghost_box(position, archetype);
+    return (edge_intersects(player.position, player.aftr.position, {box.min.x, box.min.y}, {box.max.x, box.min.y}) ||
+            edge_intersects(player.position, player.aftr.position, {box.max.x, box.min.y}, {box.max.x, box.max.y}) ||
+            edge_intersects(player.position, player.aftr.position, {box.max.x, box.max.y}, {box.min.x, box.max.y}) ||
+            edge_intersects(player.position, player.aftr.position, {box.min.x, box.max.y}, {box.min.x, box.min.y}));
 }
 
-bool Ghost::player_hurt(){
-    if(!player->attack) return false;
-    return (edge_intersects(player->position, player->aftr.position, {position.x - (sprite_size.x / 2 * scale.x), position.y - (sprite_size.y / 2 * scale.y)}, {position.x + (sprite_size.x / 2 * scale.x), position.y - (sprite_size.y / 2 * scale.y)}) ||
-            edge_intersects(player->position, player->aftr.position, {position.x + (sprite_size.x / 2 * scale.x), position.y - (sprite_size.y / 2 * scale.y)}, {position.x + (sprite_size.x / 2 * scale.x), position.y + (sprite_size.y / 2 * scale.y)}) ||
-            edge_intersects(player->position, player->aftr.position, {position.x + (sprite_size.x / 2 * scale.x), position.y + (sprite_size.y / 2 * scale.y)}, {position.x - (sprite_size.x / 2 * scale.x), position.y + (sprite_size.y / 2 * scale.y)}) ||
-            edge_intersects(player->position, player->aftr.position, {position.x - (sprite_size.x / 2 * scale.x), position.y + (sprite_size.y / 2 * scale.y)}, {position.x - (sprite_size.x / 2 * scale.x), position.y - (sprite_size.y / 2 * scale.y)}));
+Aabb ghost_box(sf::Vector2f position, const Ghost_Archetype& archetype){
+    return {position - archetype.half_size, position + archetype.half_size};
 }
 
-Horde::Horde(Player* player):
+Horde::Horde(Player* player, std::uint64_t seed, Timer_Wheel* timers):
         screen_center(window_width / 2, window_height / 2),
-        time_elapsed(0),
         score(0),
+        kills(0),
+        pickups(0),
+        spawns(0),
+        ghost_overflow(0),
+        heart_overflow(0),
         player(player),
-        ghost_texture(ghost_sheet),
-        heart_texture(animated_heart),
-        hit_buffer(hit_path),
-        hit_sound(hit_buffer),
-        pickup_buffer(pick_path),
-        pickup_sound(pickup_buffer){
-            hit_sound.setVolume(volume);
-            pickup_sound.setVolume(volume);
-            srand(time(0));
+        spawn_random(seed, 1),
+        drop_random(seed, 2),
+        heart_grid(grid_cell_size),
+        ghost_tree(tree_margin),
+        jobs(nullptr),
+        timers(timers),
+        spawn_timer(-1),
+        spawn_start(0),
+        spawn_wait(0){
+            //Broad phase queries cover the largest archetype, the exact tests then use each ghost's own.
+            for(unsigned a = 0; a < n_ghost_archetypes; a++){
+                archetype_speed[a] = ghost_archetypes[a].speed;
+                widest_half_size.x = std::max(widest_half_size.x, ghost_archetypes[a].half_size.x);
+                widest_half_size.y = std::max(widest_half_size.y, ghost_archetypes[a].half_size.y);
+            }
+            reserve(horde_capacity);
+            schedule_spawn();
 }
 
 //void Horde::update(float delta){}
 bool Horde::update(float delta){
+    kills = 0;
+    pickups = 0;
+    spawns = 0;
+    events.clear();
     update_horde(delta);
-    update_hearts(delta);
-    return spawn_enemies(delta);
+    update_hearts();
+    resolve_events();
+
+    //A score crossing a threshold shortens the wait already running, still counted from the last spawn.
+    if(spawn_timer != -1 && spawn_interval() != spawn_wait){
+        timers->cancel(spawn_timer);
+        spawn_wait = spawn_interval();
+        spawn_timer = timers->schedule(spawn_start + spawn_wait - timers->time(), Timer_Kind::Spawn);
+    }
+    return false;
 }
 
-void Horde::draw(sf::RenderWindow& window){
-    for(Heart& h: hearts)
-        h.draw(window);
+void Horde::schedule_spawn(){
+    spawn_start = timers->time();
+    spawn_wait = spawn_interval();
+    spawn_timer = timers->schedule(spawn_wait, Timer_Kind::Spawn);
+}
 
-    for(Ghost& g: horde)
-        g.draw(window);
+//Called when the spawn timer fires: a ghost comes in and the wait for the next one starts.
+void Horde::spawn_due(){
+    spawn_timer = -1;
+    if(spawn_ghost())
+        spawns++;
+    schedule_spawn();
 }
 
-bool Horde::spawn_enemies(float delta){
-    time_elapsed += delta;
-    if(time_elapsed >= spawn_interval()){
-        time_elapsed = 0;
-        horde.emplace_back(screen_center + sf::Vector2f(700, sf::degrees(rand() % 360)), player, ghost_texture);
-        return true;
+//A full pool drops the ghost and counts it in ghost_overflow rather than growing.
+//The tree leaf holds the ghost's handle index, which swap-and-pop does not change.
+bool Horde::spawn_ghost(){
+    sf::Vector2f position = screen_center + sf::Vector2f(700, sf::degrees(spawn_random.below(360)));
+    Handle handle = ghosts.push(position.x, position.y, position.x, position.y, timers->time(), basic_ghost, true, -1);
+    if(!handle){
+        ghost_overflow++;
+        return false;
     }
-    return false;
+    ghosts.column<Tree_Proxy>().back() = ghost_tree.create(ghost_box(position, ghost_archetypes[basic_ghost]), handle.index);
+    return true;
+}
+
+void Horde::remove_ghost(size_t i){
+    ghost_tree.destroy(ghosts.column<Tree_Proxy>()[i]);
+    ghosts.remove(i);
 }
 
 bool Horde::spawn_hearts(sf::Vector2f position){
-    if(rand() % 3 >= player->health){
-        hearts.emplace_back(player, position, heart_texture);
+    if(drop_random.below(3) >= player->health){
+        if(!hearts.push(position.x, position.y, timers->time(), player_scale.x)){
+            heart_overflow++;
+            return false;
+        }
         return true;
     }
     return false;
 }
 
 void Horde::update_horde(float delta){
-    std::list<Ghost>::iterator g = horde.begin();
-    while(g != horde.end()){
-        if(g->update(delta)){
-            hit_sound.play();
-            score += (spawn_hearts(g->position)) ? 5 : 10;
-            g = horde.erase(g);
+    PROFILE_SCOPE("Horde::update_horde");
+    ALLOC_SCOPE("Horde::update_horde");
+    //Chunks only write to their own ghosts and their own Horde_Chunk, and read the tree without changing it.
+    //They start on multiples of horde_chunk, itself a multiple of the kernel width, so each ghost steps exactly
+    //as it would in a single pass, whichever thread runs its chunk.
+    size_t n = ghosts.size();
+    chunks.resize((n + horde_chunk - 1) / horde_chunk);
+    stale.resize(n);
+    float* x = ghosts.column<Position_X>().data();
+    float* y = ghosts.column<Position_Y>().data();
+    float* prev_x = ghosts.column<Previous_X>().data();
+    float* prev_y = ghosts.column<Previous_Y>().data();
+    const unsigned char* kind = ghosts.column<Kind>().data();
+    const int* proxy = ghosts.column<Tree_Proxy>().data();
+    auto update_chunk = [this, delta, x, y, prev_x, prev_y, kind, proxy](size_t begin, size_t end){
+        Horde_Chunk& chunk = chunks[begin / horde_chunk];
+        chunk.contacts = 0;
+        chunk.stale = 0;
+        steer_towards(player->position, archetype_speed, kind + begin, delta, x + begin, y + begin, prev_x + begin, prev_y + begin, end - begin);
+
+        for(size_t i = begin; i < end; i++){
+            const Ghost_Archetype& archetype = ghost_archetypes[kind[i]];
+            sf::Vector2f position(x[i], y[i]);
+            if(!aabb_contains(ghost_tree.nodes[proxy[i]].box, ghost_box(position, archetype)))
+                stale[begin + chunk.stale++] = i;
+            if(ghost_hit(position, archetype, *player))
+                chunk.contacts++;
         }
-        else
-            g++;
+    };
+    parallel_for(jobs, n, horde_chunk, update_chunk);
+
+    //Applied in chunk order, so the tree and the player end up the same whatever ran the chunks.
+    //The fat boxes are stretched along the step just taken, scaled up to tree_prediction seconds.
+    float prediction = tree_prediction / delta;
+    for(size_t c = 0; c < chunks.size(); c++){
+        for(unsigned k = 0; k < chunks[c].stale; k++){
+            unsigned i = stale[c * horde_chunk + k];
+            sf::Vector2f position(x[i], y[i]);
+            sf::Vector2f step = position - sf::Vector2f(prev_x[i], prev_y[i]);
+            ghost_tree.move(proxy[i], ghost_box(position, ghost_archetypes[kind[i]]), step * prediction);
+        }
+        for(unsigned k = 0; k < chunks[c].contacts; k++)
+            events.push(Event_Kind::Hit);
+    }
+
+    //The dash segment only visits the branches of the tree it crosses. The leaves it reaches are slab tested
+    //in batches against boxes grown by a pixel, so rounding cannot drop a ghost the exact edge test would hit.
+    //Leaves hold handle indices, turned into slots before the ghosts are read.
+    if(player->attack){
+        size_t queued = events.events.size();
+        nearby.clear();
+        ghost_tree.query_segment(player->position, player->aftr.position, nearby);
+        batch_x.resize(nearby.size());
+        batch_y.resize(nearby.size());
+        batch_hit.resize(nearby.size());
+        for(size_t k = 0; k < nearby.size(); k++){
+            nearby[k] = ghosts.handles.slot[nearby[k]];
+            batch_x[k] = x[nearby[k]];
+            batch_y[k] = y[nearby[k]];
+        }
+        segment_hits_boxes(player->position, player->aftr.position, widest_half_size + sf::Vector2f(1, 1),
+                           batch_x.data(), batch_y.data(), nearby.size(), batch_hit.data());
+        for(size_t k = 0; k < nearby.size(); k++)
+            if(batch_hit[k] && ghost_hurt(position_of(ghosts, nearby[k]), ghost_archetypes[kind[nearby[k]]], *player))
+                events.push(Event_Kind::Kill, ghosts.handles.handle(nearby[k]));
+        if(events.events.size() > queued)
+            events.push(Event_Kind::Dash_Resolved);
     }
 }
 
-void Horde::update_hearts(float delta){
-    std::list<Heart>::iterator h = hearts.begin();
-    while(h != hearts.end()){
-        if(h->update(delta)){
-            pickup_sound.play();
-            h = hearts.erase(h);
+void Horde::update_hearts(){
+    PROFILE_SCOPE("Horde::update_hearts");
+    ALLOC_SCOPE("Horde::update_hearts");
+    if(hearts.empty()) return;
+
+    heart_grid.build(hearts.size(), [this](size_t i){return position_of(hearts, i);});
+    nearby.clear();
+    heart_grid.query(player->position, pickup_radius(hearts, 0), nearby);
+
+    for(unsigned i: nearby)
+        if(heart_picked(hearts, i, player->position))
+            events.push(Event_Kind::Pickup, hearts.handles.handle(i));
+}
+
+//The only place the update touches the player, the score and the pools. Events are applied in the order
+//they were queued, except that killed ghosts are only flagged, then scored and removed in one pass over the
+//store before the first pickup: the drop chance depends on the health a pickup restores. Events name ghosts
+//and hearts by handle, so removals in any order leave the others valid, and a stale one is skipped.
+void Horde::resolve_events(){
+    PROFILE_SCOPE("Horde::resolve_events");
+    ALLOC_SCOPE("Horde::resolve_events");
+    bool killed = false;
+    for(const Event& event: events.events){
+        if(killed && event.kind == Event_Kind::Pickup){
+            remove_killed();
+            killed = false;
+        }
+        switch(event.kind){
+            case Event_Kind::Hit:
+                player->hit();
+                break;
+            case Event_Kind::Kill:{
+                std::uint32_t i = ghosts.handles.find(event.target);
+                if(i == Handle_Registry::no_slot) break;
+                ghosts.column<Alive>()[i] = false;
+                killed = true;
+                break;
+            }
+            case Event_Kind::Pickup:{
+                std::uint32_t i = hearts.handles.find(event.target);
+                if(i == Handle_Registry::no_slot) break;
+                player->heal();
+                pickups++;
+                hearts.remove(i);
+                break;
+            }
+            case Event_Kind::Dash_Resolved:
+                player->success = true;
+                break;
+        }
+    }
+    if(killed)
+        remove_killed();
+}
+
+void Horde::remove_killed(){
+    size_t i = 0;
+    while(i < ghosts.size()){
+        if(!ghosts.column<Alive>()[i]){
+            kills++;
+            score += (spawn_hearts(position_of(ghosts, i))) ? 5 : 10;
+            remove_ghost(i);
         }
         else
-            h++;
+            i++;
     }
 }
 
+std::tuple<Ghost_Table&, Heart_Table&> Horde::tables(){
+    return {ghosts, hearts};
+}
+
 unsigned Horde::spawn_interval(){
     if(score < 100)
         return 5;
@@ -404,194 +516,84 @@ unsigned Horde::spawn_interval(){
     return 1;
 }
 
-void Horde::restart(Player* player){
-    horde.clear();
-    hearts.clear();
-    time_elapsed = 0;
+//The player is assigned in place by Simulation::restart, so the pointer to it stays good.
+void Horde::restart(){
+    for_each_table<>(tables(), [](auto& table){table.clear();});
+    ghost_tree.clear();
     score = 0;
-    this->player = player;
-}
-
-State::State():
-    player_texture(player_sheet),
-    heart_texture(heart_sprite),
-    backgournd_texture(background),
-    heart(heart_texture),
-    gameover_texture(gameover_path),
-    gameover(gameover_texture),
-    score_font(font_path),
-    hit_buffer(player_hit_path),
-    player(directions, player_texture, hit_buffer),
-    horde(&player),
-    score_file("score.txt", std::ios::in | std::ios::app),
-    game_over(false),
-    ost(ost_path),
-    defeat_ost(defeat_path){
-        heart.setScale(player_scale);
-        gameover.setScale(player_scale);
-        gameover.setOrigin(sf::Vector2f(200, 64));
-        gameover.setPosition(sf::Vector2f(window_width / 2, window_height / 2));
-
-        std::string line;
-        if(std::getline(score_file, line))
-            try{
-                high_score = stoull(line);
-            }
-            catch(...){
-                high_score = 0;
-            }
-        else
-            high_score = 0;
+    kills = 0;
+    pickups = 0;
+    spawns = 0;
+    //Simulation::restart cleared the wheel, the old spawn timer with it.
+    schedule_spawn();
+}
 
-        score_file.close();
-        ost.setLooping(true);
-        ost.setVolume(volume);
-        ost.play();
-        defeat_ost.setLooping(true);
-        defeat_ost.setVolume(volume);
+//Sizes the ghost and heart pools, and everything indexed by ghost, for n of each. Nothing grows afterwards:
+//restart recycles the same storage, and spawns past capacity are counted in ghost_overflow and heart_overflow.
+//The overflow counts cover the Horde's whole life, restarts included.
+void Horde::reserve(size_t n){
+    for_each_table<>(tables(), [n](auto& table){table.reserve(n);});
+    heart_grid.reserve(n);
+    ghost_tree.reserve(n);
+    nearby.reserve(n);
+    batch_x.reserve(n);
+    batch_y.reserve(n);
+    batch_hit.reserve(n);
+    chunks.reserve((n + horde_chunk - 1) / horde_chunk);
+    //A hit and a kill per ghost, a pickup per heart and the dash.
+    events.reserve(2 * n + hearts.capacity + 1);
+    stale.reserve(n);
 }
 
-bool State::update(float delta){
+float pickup_radius(const Heart_Table& hearts, size_t i){
+    return hearts.column<Pickup_Scale>()[i] * 15;
+}
+
+bool heart_picked(const Heart_Table& hearts, size_t i, sf::Vector2f p_position){
+    return dist(position_of(hearts, i), p_position) < pickup_radius(hearts, i);
+}
+
+Simulation::Simulation(std::uint64_t seed):
+    timers(timer_capacity),
+    player(directions, &timers),
+    horde(&player, seed, &timers),
+    game_over(false){}
+
+bool Simulation::update(float delta){
     if(game_over)   return true;
     if(player.update(delta)){
-        if(horde.score > high_score){
-            high_score = horde.score;
-            score_file.open("score.txt", std::ios::out | std::ios::trunc);
-            score_file << high_score;
-            score_file.flush();
-            score_file.close();
-        
-        }
-        ost.stop();
-        defeat_ost.play();
         game_over = true;
         return true;
     }
     horde.update(delta);
-    return false;
-}
 
-void State::draw(sf::RenderWindow& window){
-    horde.draw(window);
-    player.draw(window);
-    if(!game_over){
-        draw_background(window);
-        draw_health(window);
-        display_score(window);
-    }
-    else
-        draw_gameover(window);
-}
-
-void State::draw_health(sf::RenderWindow& window){
-    switch(player.health){
-        case 3:
-            heart.setPosition({155, 5});
-            window.draw(heart);
-        case 2:
-            heart.setPosition({80, 5});
-            window.draw(heart);
-        case 1:
-            heart.setPosition({5, 5});
-            window.draw(heart);
-    }
+    //Timers fire at the end of the tick that reaches them, after everything they could end or start was updated.
+    timers.advance(delta);
+    for(const Timer& timer: timers.fired)
+        fire(timer);
+    return false;
 }
 
-void State::display_score(sf::RenderWindow& window){
-    sf::Text score_text(score_font, std::to_string(horde.score), 70);
-    score_text.setFillColor(sf::Color::Black);
-    score_text.setPosition(sf::Vector2f(window_width - 300, -10));
-    window.draw(score_text);
-}
-
-void State::draw_background(sf::RenderWindow& window){
-    sf::Vector2i size(32, 32);
-    sf::Sprite tile(backgournd_texture);
-    tile.setScale(sf::Vector2f(player_scale.x / 2, player_scale.y / 2));
-    for(size_t j = 0; j < 9 ; j++){
-        for(size_t i = 0; i < 16; i++){
-
-            switch(j){
-                case 0:
-                    tile.setTextureRect(sf::IntRect(sf::Vector2i(32, 32), size));
-                    break;
-                case 1:
-                    if(i == 0)
-                        tile.setTextureRect(sf::IntRect(sf::Vector2i(0, 0), size));
-                    else if(i == 15)
-                        tile.setTextureRect(sf::IntRect(sf::Vector2i(96, 0), size));
-                    else
-                        tile.setTextureRect(sf::IntRect(sf::Vector2i(32, 0), size));
-                    break;
-                case 8:
-                    if(i == 0)
-                        tile.setTextureRect(sf::IntRect(sf::Vector2i(0, 96), size));
-                    else if(i == 15)
-                        tile.setTextureRect(sf::IntRect(sf::Vector2i(96, 96), size));
-                    else
-                        tile.setTextureRect(sf::IntRect(sf::Vector2i(32, 96), size));
-                    break;
-                default:
-                    if(i == 0)
-                        tile.setTextureRect(sf::IntRect(sf::Vector2i(0, 32), size));
-                    else if(i == 15)
-                        tile.setTextureRect(sf::IntRect(sf::Vector2i(96, 32), size));
-                    else
-                        continue;
-                    break;
-            }
-
-            tile.setPosition(sf::Vector2f(i * 80, j * 80));
-            window.draw(tile);
-        }
+void Simulation::fire(const Timer& timer){
+    switch(timer.kind){
+        case Timer_Kind::Invulnerability:
+            player.inv_timer = -1;
+            player.invulnerable = false;
+            break;
+        case Timer_Kind::Dash_Fail:
+            player.fail_timer = -1;
+            player.fail = false;
+            break;
+        case Timer_Kind::Spawn:
+            horde.spawn_due();
+            break;
     }
 }
 
-void State::restart(){
+void Simulation::restart(){
     if(!game_over)  return;
     game_over = false;
-    player = Player(directions, player_texture, hit_buffer);
-    horde.restart(&player);
-    defeat_ost.stop();
-    ost.play();
-}
-
-void State::draw_gameover(sf::RenderWindow& window){
-    window.draw(gameover);
-
-    sf::Text retry(score_font, "Press [SPACE] to restart", 50);
-    retry.setFillColor(sf::Color::Black);
-    retry.setOutlineThickness(3);
-    retry.setOutlineColor(sf::Color::White);
-    retry.setPosition(sf::Vector2f(250, 600));
-    window.draw(retry);
-
-    retry.setPosition(sf::Vector2f(150, 75));
-    retry.setString("score: " + std::to_string(horde.score) + "\nhigh score: " + std::to_string(high_score));
-    window.draw(retry);
-}
-
-Heart::Heart(Player* player, sf::Vector2f position, sf::Texture& texture):
-    position(position),
-    sprite(texture),
-    player(player),
-    anim(animation_fps_period, h_sheet, heart_sprite_size),
-    scale(player_scale.x){
-        sprite.setOrigin(sf::Vector2f(heart_sprite_size.x / 2, heart_sprite_size.y / 2));
-        sprite.setScale(player_scale);
-        sprite.setPosition(position);
-}
-
-bool Heart::update(float delta){
-    anim.update(delta);
-    if(dist(position, player->position) < scale * 15){
-        player->heal();
-        return true;
-    }
-    return false;
+    timers.clear();
+    player = Player(directions, &timers);
+    horde.restart();
 }
-
-void Heart::draw(sf::RenderWindow& window){
-    sprite.setTextureRect(anim.get_sprite(0, false));
-    window.draw(sprite);
-}
\ No newline at end of file
@@ -1,174 +1,239 @@
-#include <SFML/Graphics.hpp>
-#include <SFML/Audio.hpp>
-#include <fstream>
+#pragma once
+
+#include "spatial.hpp"
+#include "kernels.hpp"
+#include "jobs.hpp"
+#include "timers.hpp"
+#include "ecs.hpp"
+#include <SFML/System/Vector2.hpp>
+#include <SFML/System/Angle.hpp>
+#include <SFML/Graphics/Rect.hpp>
 
 #ifndef _WIN32
-    #include <list>
+    #include <cstdint>
+    #include <vector>
 #endif
 
-struct Updatable{
-    virtual bool update(float delta) = 0;
-    virtual void draw(sf::RenderWindow& window) = 0;
-};
+float dist(sf::Vector2f p1, sf::Vector2f p2);
+sf::Angle angle(sf::Vector2f p1, sf::Vector2f p2);
+sf::Vector2f lerp(sf::Vector2f p1, sf::Vector2f p2, float t);
+bool edge_intersects(const sf::Vector2f& a, const sf::Vector2f& b, const sf::Vector2f& c, const sf::Vector2f& d);
 
-struct Animation_Updater: Updatable{
-    float time_elapsed;
-    int progression;
-    float period;
-    unsigned max;
-    sf::Vector2i sprite_size;
+//PCG32 generator: the same seed gives an independent sequence for every stream id.
+struct Random{
+    std::uint64_t state;
+    std::uint64_t inc;
 
-    Animation_Updater(float period, unsigned max, sf::Vector2i sprite_size);
+    Random(std::uint64_t seed, std::uint64_t stream);
 
-    bool update(float delta) override;
-    void draw(sf::RenderWindow& window) override;
-
-    sf::IntRect get_sprite(int direction, bool moving);
+    std::uint32_t next();
+    std::uint32_t below(std::uint32_t bound);
 };
 
-struct Entity: Updatable{
+struct After_Image{
     sf::Vector2f position;
-    sf::Vector2f origin;
-    sf::Vector2i sprite_size;
-    sf::Vector2f scale;
-    sf::Vector2f size;
-    sf::Sprite sprite;
-    Animation_Updater anim;
+    sf::IntRect rect;
     unsigned sprite_direction;
-    bool moving;
 
-    Entity(sf::Vector2f position, sf::Vector2f origin, const sf::Vector2i sprite_size, const sf::Vector2f scale, const float animation_period, const unsigned n_frames, unsigned sprite_direction, sf::Texture& texture);
+    After_Image();
 
-    bool update(float delta) override;
-    void draw(sf::RenderWindow& window) override;
+    void set_start(sf::IntRect rect, sf::Vector2f position, unsigned sprite_direction);
 };
 
-struct After_Image: Updatable{
+//Game logic only: nothing here owns a texture, a sound or a window, so it can run headless.
+//There is a single player, so it is one plain struct rather than a row of an archetype table.
+//anim_start is when its animation started on the shared clock, see animation.hpp.
+struct Player{
     sf::Vector2f position;
-    sf::Sprite sprite;
+    sf::Vector2f origin;
+    sf::Vector2i sprite_size;
+    sf::Vector2f scale;
+    sf::Vector2f size;
+    float anim_start;
     unsigned sprite_direction;
-
-    After_Image(sf::Vector2f origin, sf::Vector2f size, sf::Texture& texture);
-
-    bool update(float delta) override;
-    void draw(sf::RenderWindow& window) override;
-
-    void set_start(sf::IntRect rect, sf::Vector2f position, unsigned sprite_direction);
-};
-
-struct Player: Entity{
+    bool moving;
+    sf::Vector2f prev_position;
     float speed;
     bool dashing;
     bool invulnerable;
-    float inv_window;
-    float fail_window;
     bool dead;
     bool attack;
     bool prev_attack;
     bool success;
     bool fail;
+    bool hurt;
     After_Image aftr;
     unsigned health;
     bool* directions;
     sf::Vector2u screen_size;
-    sf::Sound hit_sound;
+    Timer_Wheel* timers;
+    int inv_timer;
+    int fail_timer;
 
-    Player(bool directions[4], sf::Texture& texture, sf::SoundBuffer& hit_buffer);
+    Player(bool directions[4], Timer_Wheel* timers);
 
-    bool update(float delta) override;
-    void draw(sf::RenderWindow& window) override;
+    bool update(float delta);
 
     void calculate_direction(sf::Vector2f dir);
     void start_dash();
     void stop_dash();
-    void draw_line(sf::RenderWindow& window);
     void move_and_collide(sf::Vector2f direction, float delta);
     void hit();
     void successful_dash();
     void heal();
-    void draw_fail_bar(sf::RenderWindow& window);
+    void start_fail();
+    float fail_progress() const;
+    sf::IntRect sprite_rect() const;
 };
 
-struct Ghost: Entity{
+//Everything the ghosts of one kind have in common. A ghost only stores the index of its kind in ghost_archetypes,
+//next to its position and the time its animation started. frame_rects holds a rect per frame of its sheet row.
+//A new enemy kind is a new entry here, the systems below handle it without any new type.
+struct Ghost_Archetype{
+    sf::Vector2i sprite_size;
+    const sf::IntRect* frame_rects;
+    sf::Vector2f origin;
+    sf::Vector2f scale;
+    sf::Vector2f half_size;
     float speed;
-    Player* player;
-
-    Ghost(sf::Vector2f position, Player* player, sf::Texture& texture);
+    float frame_period;
+    unsigned frames;
+};
 
-    bool update(float delta) override;
-    void draw(sf::RenderWindow& window) override;
+const unsigned char basic_ghost = 0;
+const unsigned n_ghost_archetypes = 1;
+extern const Ghost_Archetype ghost_archetypes[n_ghost_archetypes];
+
+//Components of the horde's archetype tables, see ecs.hpp. Previous_X and Previous_Y are where the ghost was
+//before the last step, for interpolation. Kind indexes ghost_archetypes. Tree_Proxy is the ghost's leaf in the
+//Horde's AABB tree. Pickup_Scale sizes a heart and its pickup radius.
+struct Position_X{typedef float type;};
+struct Position_Y{typedef float type;};
+struct Previous_X{typedef float type;};
+struct Previous_Y{typedef float type;};
+struct Animation_Start{typedef float type;};
+struct Kind{typedef unsigned char type;};
+struct Alive{typedef unsigned char type;};
+struct Tree_Proxy{typedef int type;};
+struct Pickup_Scale{typedef float type;};
+
+//Dead ghosts are flagged during the update and removed afterwards with swap-and-pop, so order is not kept.
+typedef Archetype<Position_X, Position_Y, Previous_X, Previous_Y, Animation_Start, Kind, Alive, Tree_Proxy> Ghost_Table;
+//Nothing to update: a heart only waits to be picked, and its animation is read from the shared clock.
+typedef Archetype<Position_X, Position_Y, Animation_Start, Pickup_Scale> Heart_Table;
+
+template <typename Table>
+sf::Vector2f position_of(const Table& table, size_t i){
+    return sf::Vector2f(table.template column<Position_X>()[i], table.template column<Position_Y>()[i]);
+}
+
+//Between the previous and the current position, for rendering.
+template <typename Table>
+sf::Vector2f position_of(const Table& table, size_t i, float alpha){
+    sf::Vector2f previous(table.template column<Previous_X>()[i], table.template column<Previous_Y>()[i]);
+    return lerp(previous, position_of(table, i), alpha);
+}
+
+float ghost_contact_radius(const Ghost_Archetype& archetype, const Player& player);
+bool ghost_hit(sf::Vector2f position, const Ghost_Archetype& archetype, const Player& player);
+bool ghost_hurt(sf::Vector2f position, const Ghost_Archetype& archetype, const Player& player);
+Aabb ghost_box(sf::Vector2f position, const Ghost_Archetype& archetype);
+
+float pickup_radius(const Heart_Table& hearts, size_t i);
+bool heart_picked(const Heart_Table& hearts, size_t i, sf::Vector2f p_position);
+
+//Gameplay side effects found while updating the horde, applied together by Horde::resolve_events.
+//target is the ghost of a Kill and the heart of a Pickup, null otherwise.
+enum class Event_Kind: std::uint8_t{
+    Hit,
+    Kill,
+    Pickup,
+    Dash_Resolved
+};
 
-    bool player_hit(sf::Vector2f p_position);
-    bool player_hurt();
+struct Event{
+    Event_Kind kind;
+    Handle target;
 };
 
-struct Heart: Updatable{
-    sf::Vector2f position;
-    sf::Sprite sprite;
-    Player* player;
-    Animation_Updater anim;
-    float scale;
+//Preallocated like the pools: an event past capacity is counted in overflow and dropped.
+struct Event_Queue{
+    std::vector<Event> events;
+    size_t capacity = 0;
+    unsigned long long overflow = 0;
 
-    Heart(Player* player, sf::Vector2f position, sf::Texture& texture);
-    
-    bool update(float delta) override;
-    void draw(sf::RenderWindow& window) override;
+    bool push(Event_Kind kind, Handle target = Handle());
+    void clear();
+    void reserve(size_t n);
 };
 
-struct Horde: Updatable{
-    std::list<Ghost> horde;
-    std::list<Heart> hearts;
+//What a chunk of ghosts leaves for the serial part of the update: how many of its ghosts touch the player,
+//and how many left their fat box, listed from the chunk's first slot in Horde::stale.
+struct Horde_Chunk{
+    unsigned contacts;
+    unsigned stale;
+};
+
+struct Horde{
+    Ghost_Table ghosts;
+    Heart_Table hearts;
+    Event_Queue events;
     sf::Vector2f screen_center;
-    float time_elapsed;
     unsigned long long score;
+    unsigned kills;
+    unsigned pickups;
+    unsigned spawns;
+    unsigned long long ghost_overflow;
+    unsigned long long heart_overflow;
     Player* player;
-    sf::Texture ghost_texture;
-    sf::Texture heart_texture;
-    sf::SoundBuffer hit_buffer;
-    sf::Sound hit_sound;
-    sf::SoundBuffer pickup_buffer;
-    sf::Sound pickup_sound;
-
-    Horde(Player* player);
-
-    bool update(float delta) override;
-    void draw(sf::RenderWindow& window) override;
-
-    bool spawn_enemies(float delta);
+    Random spawn_random;
+    Random drop_random;
+    Spatial_Grid heart_grid;
+    Aabb_Tree ghost_tree;
+    std::vector<unsigned> nearby;
+    std::vector<float> batch_x;
+    std::vector<float> batch_y;
+    std::vector<unsigned char> batch_hit;
+    std::vector<Horde_Chunk> chunks;
+    std::vector<unsigned> stale;
+    float archetype_speed[n_ghost_archetypes];
+    sf::Vector2f widest_half_size;
+    Job_System* jobs;
+    Timer_Wheel* timers;
+    int spawn_timer;
+    float spawn_start;
+    unsigned spawn_wait;
+
+    Horde(Player* player, std::uint64_t seed, Timer_Wheel* timers);
+
+    bool update(float delta);
+    std::tuple<Ghost_Table&, Heart_Table&> tables();
+
+    void schedule_spawn();
+    void spawn_due();
+    bool spawn_ghost();
+    void remove_ghost(size_t i);
     bool spawn_hearts(sf::Vector2f position);
     void update_horde(float delta);
-    void update_hearts(float delta);
+    void update_hearts();
+    void resolve_events();
+    void remove_killed();
     unsigned spawn_interval();
-    void restart(Player* player);
+    void restart();
+    void reserve(size_t n);
 };
 
-struct State: Updatable{
-    sf::Texture player_texture;
-    sf::Texture heart_texture;
-    sf::Texture backgournd_texture;
-    sf::Texture gameover_texture;
-    sf::Sprite gameover;
-    sf::Sprite heart;
-    sf::Font score_font;
-    sf::SoundBuffer hit_buffer;
+struct Simulation{
+    bool directions[4] = {false, false, false, false};
+    Timer_Wheel timers;
     Player player;
     Horde horde;
-    bool directions[4] = {false, false, false, false};
-    std::fstream score_file;
-    unsigned long long high_score;
     bool game_over;
-    sf::Music ost;
-    sf::Music defeat_ost;
-    
 
-    State();
+    Simulation(std::uint64_t seed);
 
-    bool update(float delta) override;
-    void draw(sf::RenderWindow& window) override;
+    bool update(float delta);
 
-    void draw_health(sf::RenderWindow& window);
-    void display_score(sf::RenderWindow& window);
-    void draw_background(sf::RenderWindow& window);
-    void draw_gameover(sf::RenderWindow& window);
     void restart();
-};
\ No newline at end of file
+    void fire(const Timer& timer);
+};
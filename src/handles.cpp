@@ -0,0 +1,81 @@
+#include "handles.hpp"
+
+Handle::operator bool() const{
+    return generation != 0;
+}
+
+bool operator==(Handle a, Handle b){
+    return a.index == b.index && a.generation == b.generation;
+}
+
+bool operator!=(Handle a, Handle b){
+    return !(a == b);
+}
+
+size_t Handle_Registry::size() const{
+    return owner.size();
+}
+
+//The lowest free index is handed out first, so a fresh or cleared registry always gives the same handles.
+Handle Handle_Registry::create(){
+    if(free_list.empty())
+        return Handle();
+    std::uint32_t index = free_list.back();
+    free_list.pop_back();
+    slot[index] = owner.size();
+    owner.push_back(index);
+    return {index, generation[index]};
+}
+
+Handle Handle_Registry::handle(size_t slot) const{
+    std::uint32_t index = owner[slot];
+    return {index, generation[index]};
+}
+
+bool Handle_Registry::valid(Handle handle) const{
+    return handle.index < capacity && slot[handle.index] != no_slot && generation[handle.index] == handle.generation;
+}
+
+std::uint32_t Handle_Registry::find(Handle handle) const{
+    return valid(handle) ? slot[handle.index] : no_slot;
+}
+
+//Mirrors the pool's swap-and-pop: the handle of the last slot now names slot i.
+//The generation skips 0 when it wraps, so the handle never turns null.
+void Handle_Registry::remove(size_t i){
+    std::uint32_t index = owner[i];
+    std::uint32_t last = owner.back();
+    owner[i] = last;
+    slot[last] = i;
+    owner.pop_back();
+
+    slot[index] = no_slot;
+    if(++generation[index] == 0)
+        generation[index] = 1;
+    free_list.push_back(index);
+}
+
+//Every live handle goes stale, and the free list is rebuilt in the order a fresh registry hands them out.
+void Handle_Registry::clear(){
+    for(std::uint32_t index: owner){
+        if(++generation[index] == 0)
+            generation[index] = 1;
+        slot[index] = no_slot;
+    }
+    owner.clear();
+    free_list.clear();
+    for(size_t index = capacity; index-- > 0;)
+        free_list.push_back(index);
+}
+
+//Only ever grows. The new indices go under the free list, after the ones already free.
+void Handle_Registry::reserve(size_t n){
+    if(n <= capacity) return;
+    generation.resize(n, 1);
+    slot.resize(n, no_slot);
+    owner.reserve(n);
+    free_list.insert(free_list.begin(), n - capacity, 0);
+    for(size_t k = 0; k < n - capacity; k++)
+        free_list[k] = n - 1 - k;
+    capacity = n;
+}
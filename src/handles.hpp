@@ -0,0 +1,42 @@
+#pragma once
+
+#ifndef _WIN32
+    #include <cstddef>
+    #include <cstdint>
+    #include <vector>
+#endif
+
+//Names an entity without pointing into its storage: index picks an entry of the Handle_Registry and
+//generation must match the entry's, which changes every time the entity behind it is removed.
+//Generation 0 is never handed out, so a default Handle is null.
+struct Handle{
+    std::uint32_t index = 0;
+    std::uint32_t generation = 0;
+
+    explicit operator bool() const;
+};
+
+bool operator==(Handle a, Handle b);
+bool operator!=(Handle a, Handle b);
+
+//Maps handles to the slots of a packed pool and back. The pool appends with create() and removes with
+//swap-and-pop through remove(slot), so entities move around while their handles stay valid, and a handle
+//kept past its entity's removal finds nothing instead of whatever took its slot.
+//Fixed capacity like the pools it serves: reserve sizes it, and create() refuses once every handle is live.
+struct Handle_Registry{
+    static constexpr std::uint32_t no_slot = UINT32_MAX;
+    size_t capacity = 0;
+    std::vector<std::uint32_t> generation;
+    std::vector<std::uint32_t> slot;
+    std::vector<std::uint32_t> owner;
+    std::vector<std::uint32_t> free_list;
+
+    size_t size() const;
+    Handle create();
+    Handle handle(size_t slot) const;
+    bool valid(Handle handle) const;
+    std::uint32_t find(Handle handle) const;
+    void remove(size_t slot);
+    void clear();
+    void reserve(size_t n);
+};
@@ -0,0 +1,325 @@
+#include "entities.hpp"
+#include "defaults.hpp"
+#include "profiler.hpp"
+#include "alloc.hpp"
+#include "jobs.hpp"
+#include <SFML/System/Clock.hpp>
+
+#ifndef _WIN32
+    #include <algorithm>
+    #include <chrono>
+    #include <iostream>
+    #include <memory>
+    #include <string>
+    #include <vector>
+    #include <sys/resource.h>
+#else
+    #include <windows.h>
+    #include <psapi.h>
+#endif
+
+//Runs the Simulation without a window, textures or audio and reports how fast it ticks.
+struct Scenario{
+    std::string name = "custom";
+    float duration = 60;
+    float dt = simulation_period;
+    std::uint64_t seed = 0;
+    unsigned ghosts = 0;
+    std::string input;
+    float turn_period = 0;
+    float dash_period = 0;
+    unsigned health = 0;
+    bool invulnerable = false;
+    unsigned long long score = 0;
+    float zero_alloc = -1;
+    unsigned threads = default_workers();
+};
+
+//Named scenarios reproducing the loads seen in real games, all with a fixed seed.
+//heart_farming keeps the player at 1 HP, where ghosts drop the most hearts, and out of harm's way so the farming goes on.
+bool preset(const std::string& name, Scenario& scenario){
+    scenario = Scenario();
+    scenario.name = name;
+    if(name == "idle_5k")
+        scenario.ghosts = 5000;
+    else if(name == "dash_spam"){
+        scenario.ghosts = 3000;
+        scenario.input = "dsaw";
+        scenario.turn_period = 0.5;
+        scenario.dash_period = 0.25;
+    }
+    else if(name == "heart_farming"){
+        scenario.ghosts = 300;
+        scenario.input = "dsaw";
+        scenario.turn_period = 1;
+        scenario.dash_period = 0.5;
+        scenario.health = 1;
+        scenario.invulnerable = true;
+    }
+    else if(name == "score_1000"){
+        scenario.input = "dsaw";
+        scenario.turn_period = 1;
+        scenario.dash_period = 1;
+        scenario.score = 1000;
+    }
+    else
+        return false;
+    return true;
+}
+
+const char* const presets[] = {"idle_5k", "dash_spam", "heart_farming", "score_1000"};
+
+void usage(const char* name){
+    std::cerr << "usage: " << name << " [--scenario name|all] [--duration seconds] [--dt seconds] [--seed n] [--ghosts n] [--input wasd] [--turn seconds] [--dash seconds] [--zero-alloc seconds] [--threads n]\n"
+              << "  --scenario  start from a named scenario, later options override it:\n"
+              << "              idle_5k, dash_spam, heart_farming, score_1000, or all of them in turn as defined\n"
+              << "  --duration  simulated time to run (default 60)\n"
+              << "  --dt        fixed step fed to Simulation::update (default 1/120, as in the game)\n"
+              << "  --seed      seed for the spawn and drop streams (default 0)\n"
+              << "  --ghosts    ghosts spawned before the first tick and after every restart (default 0)\n"
+              << "  --input     directions held for the whole run, any of w a s d\n"
+              << "  --turn      hold one direction of --input at a time, moving to the next every given seconds\n"
+              << "  --dash      start a dash every given seconds and release it half way (default off)\n"
+              << "  --zero-alloc  fail if any tick allocates once the given seconds of warm up are over,\n"
+              << "              needs a build with DASHER_TRACK_ALLOCATIONS\n"
+              << "  --threads   worker threads helping with the horde update, 0 for none\n"
+              << "              (default one less than the hardware threads)\n";
+}
+
+bool parse(int argc, char** argv, Scenario& scenario, bool& all){
+    for(int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        if(i + 1 >= argc)
+            return false;
+        try{
+            if(arg == "--scenario"){
+                std::string name = argv[++i];
+                all = name == "all";
+                if(!all && !preset(name, scenario))
+                    return false;
+            }
+            else if(arg == "--duration")
+                scenario.duration = std::stof(argv[++i]);
+            else if(arg == "--dt")
+                scenario.dt = std::stof(argv[++i]);
+            else if(arg == "--seed")
+                scenario.seed = std::stoull(argv[++i]);
+            else if(arg == "--ghosts")
+                scenario.ghosts = std::stoul(argv[++i]);
+            else if(arg == "--input")
+                scenario.input = argv[++i];
+            else if(arg == "--turn")
+                scenario.turn_period = std::stof(argv[++i]);
+            else if(arg == "--dash")
+                scenario.dash_period = std::stof(argv[++i]);
+            else if(arg == "--zero-alloc")
+                scenario.zero_alloc = std::stof(argv[++i]);
+            else if(arg == "--threads")
+                scenario.threads = std::stoul(argv[++i]);
+            else
+                return false;
+        }
+        catch(...){
+            return false;
+        }
+    }
+    return scenario.dt > 0 && scenario.duration >= 0;
+}
+
+void hold_input(const std::string& input, bool directions[4]){
+    for(char c: input)
+        switch(c){
+            case 'w':
+                directions[3] = true;
+                break;
+            case 'a':
+                directions[1] = true;
+                break;
+            case 's':
+                directions[2] = true;
+                break;
+            case 'd':
+                directions[0] = true;
+                break;
+        }
+}
+
+//Peak resident set size of the whole process in kilobytes: with --scenario all it only grows from one scenario to the next.
+unsigned long long peak_memory(){
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if(GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return counters.PeakWorkingSetSize / 1024;
+    return 0;
+#else
+    rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage))
+        return 0;
+    #ifdef __APPLE__
+        return usage.ru_maxrss / 1024;
+    #else
+        return usage.ru_maxrss;
+    #endif
+#endif
+}
+
+//Tick times are kept in microseconds, one per tick, and sorted once at the end for the percentiles.
+float percentile(std::vector<float>& times, float p){
+    if(times.empty()) return 0;
+    size_t k = std::min(times.size() - 1, size_t(p * times.size()));
+    std::nth_element(times.begin(), times.begin() + k, times.end());
+    return times[k];
+}
+
+//Applied at the start and after every restart, so a death does not take the load away.
+void start(Simulation& sim, const Scenario& scenario){
+    if(scenario.health)
+        sim.player.health = scenario.health;
+    sim.horde.score = scenario.score;
+    sim.horde.reserve(scenario.ghosts + horde_capacity);
+    for(unsigned i = 0; i < scenario.ghosts; i++)
+        sim.horde.spawn_ghost();
+}
+
+//Returns false when --zero-alloc was given and a tick past the warm up allocated.
+bool run(const Scenario& scenario){
+    Simulation sim(scenario.seed);
+    std::unique_ptr<Job_System> jobs;
+    if(scenario.threads){
+        jobs.reset(new Job_System(scenario.threads));
+        sim.horde.jobs = jobs.get();
+    }
+    hold_input(scenario.input, sim.directions);
+    start(sim, scenario);
+
+    unsigned long long ticks = 0;
+    unsigned long long kills = 0;
+    unsigned long long pickups = 0;
+    unsigned deaths = 0;
+    size_t peak_ghosts = sim.horde.ghosts.size();
+    float time = 0;
+    float dash_time = 0;
+    float turn_time = 0;
+    size_t turn = 0;
+    std::vector<float> tick_times;
+    tick_times.reserve(scenario.duration / scenario.dt + 1);
+    Allocation_Counts allocations{0, 0};
+    unsigned long long peak_tick_allocations = 0;
+    bool clean = true;
+
+    typedef std::chrono::steady_clock clock;
+    sf::Clock wall;
+    while(time < scenario.duration){
+        if(scenario.turn_period > 0 && !scenario.input.empty()){
+            turn_time += scenario.dt;
+            if(turn_time >= scenario.turn_period){
+                turn_time -= scenario.turn_period;
+                turn++;
+            }
+            std::fill(sim.directions, sim.directions + 4, false);
+            hold_input(scenario.input.substr(turn % scenario.input.size(), 1), sim.directions);
+        }
+        if(scenario.dash_period > 0){
+            dash_time += scenario.dt;
+            if(dash_time >= scenario.dash_period){
+                dash_time -= scenario.dash_period;
+                sim.player.start_dash();
+            }
+            else if(dash_time >= scenario.dash_period / 2)
+                sim.player.stop_dash();
+        }
+
+        allocation_tracker().begin_frame();
+        clock::time_point tick_start = clock::now();
+        bool over = sim.update(scenario.dt);
+        tick_times.push_back(std::chrono::duration<float, std::micro>(clock::now() - tick_start).count());
+
+        Allocation_Counts tick = allocation_tracker().frame();
+        allocations.allocations += tick.allocations;
+        allocations.bytes += tick.bytes;
+        peak_tick_allocations = std::max(peak_tick_allocations, tick.allocations);
+        if(clean && scenario.zero_alloc >= 0 && time >= scenario.zero_alloc && tick.allocations){
+            clean = false;
+            std::cerr << "tick " << ticks << " at " << time << " s allocated " << tick.allocations << " times, " << tick.bytes << " bytes\n";
+            const Allocation_Tracker& tracker = allocation_tracker();
+            for(int i = 0; i < tracker.n_scopes; i++)
+                if(tracker.scopes[i].counts.allocations)
+                    std::cerr << "  " << tracker.scopes[i].name << ": " << tracker.scopes[i].counts.allocations << "\n";
+        }
+        if(over){
+            deaths++;
+            sim.restart();
+            start(sim, scenario);
+        }
+        else if(scenario.health)
+            sim.player.health = scenario.health;
+        if(scenario.invulnerable){
+            sim.player.invulnerable = true;
+        }
+        kills += sim.horde.kills;
+        pickups += sim.horde.pickups;
+        if(sim.horde.ghosts.size() > peak_ghosts)
+            peak_ghosts = sim.horde.ghosts.size();
+
+        time += scenario.dt;
+        ticks++;
+    }
+    float elapsed = wall.getElapsedTime().asSeconds();
+
+    std::cout << "scenario: " << scenario.name << "\n"
+              << "worker threads: " << scenario.threads << "\n"
+              << "ticks: " << ticks << "\n"
+              << "simulated: " << time << " s\n"
+              << "wall: " << elapsed << " s\n"
+              << "ticks/s: " << (elapsed > 0 ? ticks / elapsed : 0) << "\n"
+              << "simulated s/wall s: " << (elapsed > 0 ? time / elapsed : 0) << "\n"
+              << "tick p50: " << percentile(tick_times, 0.5) << " us\n"
+              << "tick p99: " << percentile(tick_times, 0.99) << " us\n"
+              << "peak memory: " << peak_memory() << " KiB\n"
+              << "ghosts: " << sim.horde.ghosts.size() << " (peak " << peak_ghosts << ")\n"
+              << "hearts: " << sim.horde.hearts.size() << "\n"
+              << "kills: " << kills << "\n"
+              << "pickups: " << pickups << "\n"
+              << "score: " << sim.horde.score << "\n"
+              << "deaths: " << deaths << "\n"
+              << "pool overflow: " << sim.horde.ghost_overflow << " ghosts, " << sim.horde.heart_overflow << " hearts\n";
+    if(allocation_tracking())
+        std::cout << "allocations: " << allocations.allocations << " (" << allocations.bytes << " bytes, peak " << peak_tick_allocations << " per tick)\n";
+    if(scenario.zero_alloc >= 0)
+        std::cout << "zero allocation: " << (clean ? "passed" : "FAILED") << "\n";
+    return clean;
+}
+
+int main(int argc, char** argv){
+    Scenario scenario;
+    bool all = false;
+    if(!parse(argc, argv, scenario, all)){
+        usage(argv[0]);
+        return 1;
+    }
+    if(scenario.zero_alloc >= 0 && !allocation_tracking()){
+        std::cerr << "--zero-alloc needs a build with DASHER_TRACK_ALLOCATIONS\n";
+        return 1;
+    }
+
+    bool clean = true;
+    if(all){
+        float zero_alloc = scenario.zero_alloc;
+        unsigned threads = scenario.threads;
+        for(const char* name: presets){
+            preset(name, scenario);
+            scenario.zero_alloc = zero_alloc;
+            scenario.threads = threads;
+            clean = run(scenario) && clean;
+            std::cout << "\n";
+        }
+    }
+    else
+        clean = run(scenario);
+
+#ifdef DASHER_PROFILE
+    if(!profiler().write_chrome_trace(trace_path))
+        std::cerr << "could not write " << trace_path << "\n";
+#endif
+    return clean ? 0 : 1;
+}
@@ -0,0 +1,108 @@
+#include "hud.hpp"
+#include "defaults.hpp"
+#include "arena.hpp"
+
+#ifndef _WIN32
+    #include <algorithm>
+#endif
+
+Hud::Hud(const sf::Font& font, const sf::Texture& heart_texture):
+    score_text(font, "0", 70),
+    retry_text(font, "Press [SPACE] to restart", 50),
+    results_text(font, "", 50),
+    debug_text(font, "", 20),
+    health_batch(heart_texture),
+    score(0),
+    high_score(0),
+    health(0),
+    score_dirty(true),
+    results_dirty(true),
+    health_dirty(true),
+    show_debug(false),
+    frame_allocations{0, 0}{
+        score_text.setFillColor(sf::Color::Black);
+        score_text.setPosition(sf::Vector2f(window_width - 300, -10));
+
+        retry_text.setFillColor(sf::Color::Black);
+        retry_text.setOutlineThickness(3);
+        retry_text.setOutlineColor(sf::Color::White);
+        retry_text.setPosition(sf::Vector2f(250, 600));
+
+        results_text.setFillColor(sf::Color::Black);
+        results_text.setOutlineThickness(3);
+        results_text.setOutlineColor(sf::Color::White);
+        results_text.setPosition(sf::Vector2f(150, 75));
+
+        debug_text.setFillColor(sf::Color::White);
+        debug_text.setOutlineThickness(2);
+        debug_text.setOutlineColor(sf::Color::Black);
+        debug_text.setPosition(sf::Vector2f(5, window_height - 30));
+}
+
+void Hud::set_score(unsigned long long score){
+    if(score == this->score) return;
+    this->score = score;
+    score_dirty = true;
+    results_dirty = true;
+}
+
+void Hud::set_high_score(unsigned long long high_score){
+    if(high_score == this->high_score) return;
+    this->high_score = high_score;
+    results_dirty = true;
+}
+
+void Hud::set_health(unsigned health){
+    if(health == this->health) return;
+    this->health = health;
+    health_dirty = true;
+}
+
+//The text is rebuilt right away rather than on the next draw: the caller sets it before the
+//frame starts counting, so the overlay does not report its own allocations.
+void Hud::set_allocations(Allocation_Counts counts){
+    if(counts.allocations == frame_allocations.allocations && counts.bytes == frame_allocations.bytes) return;
+    frame_allocations = counts;
+    Frame_String text("allocations/frame: ");
+    append_number(text, counts.allocations);
+    text += " (";
+    append_number(text, counts.bytes);
+    text += " bytes)";
+    debug_text.setString(text.c_str());
+}
+
+void Hud::draw(sf::RenderTarget& target){
+    if(health_dirty){
+        health_batch.clear();
+        sf::Vector2f heart_size(health_batch.texture->getSize());
+        //Right to left, as the hearts overlap slightly and the leftmost one is drawn on top.
+        for(unsigned i = std::min(health, 3u); i-- > 0;)
+            health_batch.add(sf::Vector2f(5 + 75 * i, 5), sf::Vector2f(0, 0), player_scale, sf::IntRect({0, 0}, sf::Vector2i(heart_size)));
+        health_dirty = false;
+    }
+    if(score_dirty){
+        Frame_String text;
+        append_number(text, score);
+        score_text.setString(text.c_str());
+        score_dirty = false;
+    }
+
+    health_batch.draw(target);
+    target.draw(score_text);
+    if(show_debug)
+        target.draw(debug_text);
+}
+
+void Hud::draw_results(sf::RenderTarget& target){
+    if(results_dirty){
+        Frame_String text("score: ");
+        append_number(text, score);
+        text += "\nhigh score: ";
+        append_number(text, high_score);
+        results_text.setString(text.c_str());
+        results_dirty = false;
+    }
+
+    target.draw(retry_text);
+    target.draw(results_text);
+}
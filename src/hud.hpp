@@ -0,0 +1,33 @@
+#pragma once
+
+#include "batch.hpp"
+#include "alloc.hpp"
+#include <SFML/Graphics.hpp>
+
+//Retained HUD: texts and heart quads are only rebuilt when the value they show changes,
+//so a frame where nothing changed does no string formatting and no text layout.
+struct Hud{
+    sf::Text score_text;
+    sf::Text retry_text;
+    sf::Text results_text;
+    sf::Text debug_text;
+    Sprite_Batch health_batch;
+    unsigned long long score;
+    unsigned long long high_score;
+    unsigned health;
+    bool score_dirty;
+    bool results_dirty;
+    bool health_dirty;
+    bool show_debug;
+    Allocation_Counts frame_allocations;
+
+    Hud(const sf::Font& font, const sf::Texture& heart_texture);
+
+    void set_score(unsigned long long score);
+    void set_high_score(unsigned long long high_score);
+    void set_health(unsigned health);
+    void set_allocations(Allocation_Counts counts);
+
+    void draw(sf::RenderTarget& target);
+    void draw_results(sf::RenderTarget& target);
+};
@@ -0,0 +1,120 @@
+#include "jobs.hpp"
+
+bool Job_Deque::push(const Job& job){
+    std::lock_guard<std::mutex> lock(mutex);
+    if(bottom - top == capacity)
+        return false;
+    jobs[bottom++ % capacity] = job;
+    return true;
+}
+
+bool Job_Deque::pop(Job& job){
+    std::lock_guard<std::mutex> lock(mutex);
+    if(bottom == top)
+        return false;
+    job = jobs[--bottom % capacity];
+    return true;
+}
+
+bool Job_Deque::steal(Job& job){
+    std::lock_guard<std::mutex> lock(mutex);
+    if(bottom == top)
+        return false;
+    job = jobs[top++ % capacity];
+    return true;
+}
+
+unsigned default_workers(){
+    unsigned cores = std::thread::hardware_concurrency();
+    return cores > 1 ? cores - 1 : 0;
+}
+
+Job_System::Job_System(unsigned workers):
+    slots(workers + 1),
+    deques(new Job_Deque[slots]),
+    remaining(0),
+    queued(0),
+    sleeping(0),
+    quit(false){
+        threads.reserve(workers);
+        for(unsigned i = 1; i <= workers; i++)
+            threads.emplace_back(&Job_System::work, this, i);
+}
+
+Job_System::~Job_System(){
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        quit = true;
+    }
+    wake.notify_all();
+    for(std::thread& thread: threads)
+        thread.join();
+}
+
+unsigned Job_System::workers() const{
+    return slots - 1;
+}
+
+//The caller takes part in the work and only returns once every item has been processed.
+void Job_System::run(const Job& job){
+    remaining = job.end - job.begin;
+    execute(job, 0);
+    while(remaining.load(std::memory_order_acquire) > 0){
+        Job next;
+        if(find(next, 0))
+            execute(next, 0);
+        else
+            std::this_thread::yield();
+    }
+}
+
+void Job_System::execute(Job job, unsigned slot){
+    while(job.end - job.begin > job.grain){
+        size_t chunks = (job.end - job.begin + job.grain - 1) / job.grain;
+        Job upper = job;
+        upper.begin = job.begin + chunks / 2 * job.grain;
+        job.end = upper.begin;
+        push(upper, slot);
+    }
+    job.run(job.context, job.begin, job.end);
+    remaining.fetch_sub(job.end - job.begin, std::memory_order_acq_rel);
+}
+
+//A full deque is unlikely, halving keeps only a few jobs per thread: the job then just runs here.
+void Job_System::push(const Job& job, unsigned slot){
+    if(!deques[slot].push(job)){
+        execute(job, slot);
+        return;
+    }
+    queued++;
+    if(sleeping > 0){
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        wake.notify_one();
+    }
+}
+
+//The thread's own deque first, newest job first, then the oldest and largest jobs of the others.
+bool Job_System::find(Job& job, unsigned slot){
+    bool found = deques[slot].pop(job);
+    for(unsigned k = 1; k < slots && !found; k++)
+        found = deques[(slot + k) % slots].steal(job);
+    if(found)
+        queued--;
+    return found;
+}
+
+//queued and sleeping are both checked after the other side changed its own, so a push cannot slip
+//past a worker about to sleep.
+void Job_System::work(unsigned slot){
+    while(!quit){
+        Job job;
+        if(find(job, slot)){
+            execute(job, slot);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(wake_mutex);
+        sleeping++;
+        wake.wait(lock, [this]{return quit || queued > 0;});
+        sleeping--;
+    }
+}
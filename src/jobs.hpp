@@ -0,0 +1,92 @@
+#pragma once
+
+#ifndef _WIN32
+    #include <algorithm>
+    #include <atomic>
+    #include <condition_variable>
+    #include <cstddef>
+    #include <memory>
+    #include <mutex>
+    #include <thread>
+    #include <vector>
+#endif
+
+//A range of chunk aligned items to process with run(context, begin, end).
+struct Job{
+    void (*run)(void* context, size_t begin, size_t end);
+    void* context;
+    size_t begin;
+    size_t end;
+    size_t grain;
+};
+
+//Fixed capacity deque: its owner pushes and pops at the bottom, other threads steal from the top.
+struct Job_Deque{
+    static const size_t capacity = 64;
+    std::mutex mutex;
+    Job jobs[capacity];
+    size_t top = 0;
+    size_t bottom = 0;
+
+    bool push(const Job& job);
+    bool pop(Job& job);
+    bool steal(Job& job);
+};
+
+//Work stealing scheduler. Slot 0 belongs to the thread calling parallel_for, which works alongside the
+//workers until the whole range is done. A job wider than its grain is halved: the upper half is pushed
+//on the running thread's deque, where idle threads steal it, and the lower half is run on the spot.
+//Chunks always start on a multiple of the grain, so what a chunk sees does not depend on the thread count.
+//parallel_for is meant to be called from one thread at a time, and never from inside a job.
+struct Job_System{
+    unsigned slots;
+    std::unique_ptr<Job_Deque[]> deques;
+    std::vector<std::thread> threads;
+    std::atomic<size_t> remaining;
+    std::atomic<unsigned> queued;
+    std::atomic<unsigned> sleeping;
+    std::atomic<bool> quit;
+    std::mutex wake_mutex;
+    std::condition_variable wake;
+
+    Job_System(unsigned workers);
+    ~Job_System();
+
+    unsigned workers() const;
+
+    template <typename Body>
+    void parallel_for(size_t n, size_t grain, Body& body);
+
+    void run(const Job& job);
+    void execute(Job job, unsigned slot);
+    bool find(Job& job, unsigned slot);
+    void push(const Job& job, unsigned slot);
+    void work(unsigned slot);
+};
+
+//Threads available to a Job_System besides the one calling parallel_for.
+unsigned default_workers();
+
+//body(begin, end) is called on grain sized chunks of [0, n): on the workers when there is a Job_System,
+//in order on the calling thread otherwise.
+template <typename Body>
+void parallel_for(Job_System* jobs, size_t n, size_t grain, Body& body){
+    if(jobs){
+        jobs->parallel_for(n, grain, body);
+        return;
+    }
+    for(size_t begin = 0; begin < n; begin += grain)
+        body(begin, std::min(n, begin + grain));
+}
+
+template <typename Body>
+void Job_System::parallel_for(size_t n, size_t grain, Body& body){
+    if(n == 0) return;
+    Job job;
+    job.run = [](void* context, size_t begin, size_t end){(*static_cast<Body*>(context))(begin, end);};
+    job.context = &body;
+    job.begin = 0;
+    job.end = n;
+    job.grain = grain;
+    run(job);
+}
@@ -0,0 +1,232 @@
+#include "kernels.hpp"
+
+#ifndef _WIN32
+    #include <algorithm>
+    #include <cmath>
+#endif
+
+#if defined(__AVX__)
+    #include <immintrin.h>
+    #define DASHER_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define DASHER_SSE2
+#endif
+
+//The segment is the same for every box, so the sign of the direction is too: with the box centre c relative
+//to a, the slab of an axis is entered at c * inverse - |half * inverse| and left at c * inverse + |half * inverse|.
+//An axis the segment does not move along only checks that a lies inside the slab.
+struct Slab{
+    bool flat;
+    float origin;
+    float inverse;
+    float extent;
+    float half;
+
+    Slab(float origin, float direction, float half):
+        flat(direction == 0),
+        origin(origin),
+        inverse(flat ? 0 : 1 / direction),
+        extent(std::fabs(half * inverse)),
+        half(half){}
+};
+
+void segment_hits_boxes_scalar(sf::Vector2f a, sf::Vector2f b, sf::Vector2f half, const float* x, const float* y, size_t n, unsigned char* hit){
+    Slab sx(a.x, b.x - a.x, half.x);
+    Slab sy(a.y, b.y - a.y, half.y);
+    for(size_t i = 0; i < n; i++){
+        float t_min = 0, t_max = 1;
+        bool inside = true;
+
+        float cx = x[i] - sx.origin;
+        if(sx.flat)
+            inside = inside && std::fabs(cx) <= sx.half;
+        else{
+            float middle = cx * sx.inverse;
+            t_min = std::max(t_min, middle - sx.extent);
+            t_max = std::min(t_max, middle + sx.extent);
+        }
+
+        float cy = y[i] - sy.origin;
+        if(sy.flat)
+            inside = inside && std::fabs(cy) <= sy.half;
+        else{
+            float middle = cy * sy.inverse;
+            t_min = std::max(t_min, middle - sy.extent);
+            t_max = std::min(t_max, middle + sy.extent);
+        }
+
+        hit[i] = inside && t_min <= t_max;
+    }
+}
+
+void steer_towards_scalar(sf::Vector2f target, const float* speeds, const unsigned char* kind, float delta, float* x, float* y, float* prev_x, float* prev_y, size_t n){
+    for(size_t i = 0; i < n; i++){
+        float dx = target.x - x[i];
+        float dy = target.y - y[i];
+        float length = dx * dx + dy * dy;
+        if(length == 0){
+            dx = 1;
+            length = 1;
+        }
+        float scale = speeds[kind[i]] / std::sqrt(length);
+
+        prev_x[i] = x[i];
+        prev_y[i] = y[i];
+        x[i] += dx * scale * delta;
+        y[i] += dy * scale * delta;
+    }
+}
+
+#if defined(DASHER_AVX)
+
+void segment_hits_boxes(sf::Vector2f a, sf::Vector2f b, sf::Vector2f half, const float* x, const float* y, size_t n, unsigned char* hit){
+    Slab sx(a.x, b.x - a.x, half.x);
+    Slab sy(a.y, b.y - a.y, half.y);
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1);
+    const __m256 ox = _mm256_set1_ps(sx.origin), ix = _mm256_set1_ps(sx.inverse), ex = _mm256_set1_ps(sx.extent), hx = _mm256_set1_ps(sx.half);
+    const __m256 oy = _mm256_set1_ps(sy.origin), iy = _mm256_set1_ps(sy.inverse), ey = _mm256_set1_ps(sy.extent), hy = _mm256_set1_ps(sy.half);
+
+    size_t i = 0;
+    for(; i + 8 <= n; i += 8){
+        __m256 t_min = zero, t_max = one;
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+        __m256 cx = _mm256_sub_ps(_mm256_loadu_ps(x + i), ox);
+        if(sx.flat)
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_andnot_ps(sign, cx), hx, _CMP_LE_OQ));
+        else{
+            __m256 middle = _mm256_mul_ps(cx, ix);
+            t_min = _mm256_max_ps(t_min, _mm256_sub_ps(middle, ex));
+            t_max = _mm256_min_ps(t_max, _mm256_add_ps(middle, ex));
+        }
+
+        __m256 cy = _mm256_sub_ps(_mm256_loadu_ps(y + i), oy);
+        if(sy.flat)
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_andnot_ps(sign, cy), hy, _CMP_LE_OQ));
+        else{
+            __m256 middle = _mm256_mul_ps(cy, iy);
+            t_min = _mm256_max_ps(t_min, _mm256_sub_ps(middle, ey));
+            t_max = _mm256_min_ps(t_max, _mm256_add_ps(middle, ey));
+        }
+
+        int mask = _mm256_movemask_ps(_mm256_and_ps(inside, _mm256_cmp_ps(t_min, t_max, _CMP_LE_OQ)));
+        for(int lane = 0; lane < 8; lane++)
+            hit[i + lane] = (mask >> lane) & 1;
+    }
+    segment_hits_boxes_scalar(a, b, half, x + i, y + i, n - i, hit + i);
+}
+
+void steer_towards(sf::Vector2f target, const float* speeds, const unsigned char* kind, float delta, float* x, float* y, float* prev_x, float* prev_y, size_t n){
+    const __m256 tx = _mm256_set1_ps(target.x), ty = _mm256_set1_ps(target.y);
+    const __m256 dt = _mm256_set1_ps(delta);
+    const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1), half = _mm256_set1_ps(0.5f), three = _mm256_set1_ps(3);
+
+    size_t i = 0;
+    for(; i + 8 <= n; i += 8){
+        __m256 px = _mm256_loadu_ps(x + i), py = _mm256_loadu_ps(y + i);
+        __m256 dx = _mm256_sub_ps(tx, px), dy = _mm256_sub_ps(ty, py);
+        __m256 length = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+        __m256 on_target = _mm256_cmp_ps(length, zero, _CMP_EQ_OQ);
+        dx = _mm256_blendv_ps(dx, one, on_target);
+        length = _mm256_blendv_ps(length, one, on_target);
+
+        //r = r * (3 - length * r * r) / 2
+        __m256 r = _mm256_rsqrt_ps(length);
+        r = _mm256_mul_ps(_mm256_mul_ps(half, r), _mm256_sub_ps(three, _mm256_mul_ps(length, _mm256_mul_ps(r, r))));
+        const unsigned char* k = kind + i;
+        __m256 s = _mm256_set_ps(speeds[k[7]], speeds[k[6]], speeds[k[5]], speeds[k[4]], speeds[k[3]], speeds[k[2]], speeds[k[1]], speeds[k[0]]);
+        __m256 scale = _mm256_mul_ps(s, r);
+
+        __m256 velocity_x = _mm256_mul_ps(dx, scale), velocity_y = _mm256_mul_ps(dy, scale);
+        _mm256_storeu_ps(prev_x + i, px);
+        _mm256_storeu_ps(prev_y + i, py);
+        _mm256_storeu_ps(x + i, _mm256_add_ps(px, _mm256_mul_ps(velocity_x, dt)));
+        _mm256_storeu_ps(y + i, _mm256_add_ps(py, _mm256_mul_ps(velocity_y, dt)));
+    }
+    steer_towards_scalar(target, speeds, kind + i, delta, x + i, y + i, prev_x + i, prev_y + i, n - i);
+}
+
+#elif defined(DASHER_SSE2)
+
+void segment_hits_boxes(sf::Vector2f a, sf::Vector2f b, sf::Vector2f half, const float* x, const float* y, size_t n, unsigned char* hit){
+    Slab sx(a.x, b.x - a.x, half.x);
+    Slab sy(a.y, b.y - a.y, half.y);
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1);
+    const __m128 ox = _mm_set1_ps(sx.origin), ix = _mm_set1_ps(sx.inverse), ex = _mm_set1_ps(sx.extent), hx = _mm_set1_ps(sx.half);
+    const __m128 oy = _mm_set1_ps(sy.origin), iy = _mm_set1_ps(sy.inverse), ey = _mm_set1_ps(sy.extent), hy = _mm_set1_ps(sy.half);
+
+    size_t i = 0;
+    for(; i + 4 <= n; i += 4){
+        __m128 t_min = zero, t_max = one;
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+        __m128 cx = _mm_sub_ps(_mm_loadu_ps(x + i), ox);
+        if(sx.flat)
+            inside = _mm_and_ps(inside, _mm_cmple_ps(_mm_andnot_ps(sign, cx), hx));
+        else{
+            __m128 middle = _mm_mul_ps(cx, ix);
+            t_min = _mm_max_ps(t_min, _mm_sub_ps(middle, ex));
+            t_max = _mm_min_ps(t_max, _mm_add_ps(middle, ex));
+        }
+
+        __m128 cy = _mm_sub_ps(_mm_loadu_ps(y + i), oy);
+        if(sy.flat)
+            inside = _mm_and_ps(inside, _mm_cmple_ps(_mm_andnot_ps(sign, cy), hy));
+        else{
+            __m128 middle = _mm_mul_ps(cy, iy);
+            t_min = _mm_max_ps(t_min, _mm_sub_ps(middle, ey));
+            t_max = _mm_min_ps(t_max, _mm_add_ps(middle, ey));
+        }
+
+        int mask = _mm_movemask_ps(_mm_and_ps(inside, _mm_cmple_ps(t_min, t_max)));
+        for(int lane = 0; lane < 4; lane++)
+            hit[i + lane] = (mask >> lane) & 1;
+    }
+    segment_hits_boxes_scalar(a, b, half, x + i, y + i, n - i, hit + i);
+}
+
+void steer_towards(sf::Vector2f target, const float* speeds, const unsigned char* kind, float delta, float* x, float* y, float* prev_x, float* prev_y, size_t n){
+    const __m128 tx = _mm_set1_ps(target.x), ty = _mm_set1_ps(target.y);
+    const __m128 dt = _mm_set1_ps(delta);
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1), half = _mm_set1_ps(0.5f), three = _mm_set1_ps(3);
+
+    size_t i = 0;
+    for(; i + 4 <= n; i += 4){
+        __m128 px = _mm_loadu_ps(x + i), py = _mm_loadu_ps(y + i);
+        __m128 dx = _mm_sub_ps(tx, px), dy = _mm_sub_ps(ty, py);
+        __m128 length = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        //SSE2 has no blend: select with and, andnot and or.
+        __m128 on_target = _mm_cmpeq_ps(length, zero);
+        dx = _mm_or_ps(_mm_and_ps(on_target, one), _mm_andnot_ps(on_target, dx));
+        length = _mm_or_ps(_mm_and_ps(on_target, one), _mm_andnot_ps(on_target, length));
+
+        //r = r * (3 - length * r * r) / 2
+        __m128 r = _mm_rsqrt_ps(length);
+        r = _mm_mul_ps(_mm_mul_ps(half, r), _mm_sub_ps(three, _mm_mul_ps(length, _mm_mul_ps(r, r))));
+        const unsigned char* k = kind + i;
+        __m128 s = _mm_set_ps(speeds[k[3]], speeds[k[2]], speeds[k[1]], speeds[k[0]]);
+        __m128 scale = _mm_mul_ps(s, r);
+
+        __m128 velocity_x = _mm_mul_ps(dx, scale), velocity_y = _mm_mul_ps(dy, scale);
+        _mm_storeu_ps(prev_x + i, px);
+        _mm_storeu_ps(prev_y + i, py);
+        _mm_storeu_ps(x + i, _mm_add_ps(px, _mm_mul_ps(velocity_x, dt)));
+        _mm_storeu_ps(y + i, _mm_add_ps(py, _mm_mul_ps(velocity_y, dt)));
+    }
+    steer_towards_scalar(target, speeds, kind + i, delta, x + i, y + i, prev_x + i, prev_y + i, n - i);
+}
+
+#else
+
+void segment_hits_boxes(sf::Vector2f a, sf::Vector2f b, sf::Vector2f half, const float* x, const float* y, size_t n, unsigned char* hit){
+    segment_hits_boxes_scalar(a, b, half, x, y, n, hit);
+}
+
+void steer_towards(sf::Vector2f target, const float* speeds, const unsigned char* kind, float delta, float* x, float* y, float* prev_x, float* prev_y, size_t n){
+    steer_towards_scalar(target, speeds, kind, delta, x, y, prev_x, prev_y, n);
+}
+
+#endif
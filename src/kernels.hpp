@@ -0,0 +1,23 @@
+#pragma once
+
+#include <SFML/System/Vector2.hpp>
+
+#ifndef _WIN32
+    #include <cstddef>
+#endif
+
+//Batched kernels over structure of arrays data, 8 lanes at a time with AVX and 4 with SSE2.
+//Every kernel has a scalar reference that also handles the tail of a batch, so the two can be compared directly.
+
+//Slab test of the segment a-b against n boxes of half size half centred on (x[i], y[i]).
+//hit[i] is set to 1 when the segment touches the box, 0 otherwise. Batch and reference agree bit for bit.
+void segment_hits_boxes(sf::Vector2f a, sf::Vector2f b, sf::Vector2f half, const float* x, const float* y, size_t n, unsigned char* hit);
+void segment_hits_boxes_scalar(sf::Vector2f a, sf::Vector2f b, sf::Vector2f half, const float* x, const float* y, size_t n, unsigned char* hit);
+
+//Moves n entities toward target for delta seconds, keeping the previous position. Entity i moves at speeds[kind[i]],
+//the speed being shared by every entity of a kind rather than stored per entity.
+//The direction is the normalized difference vector instead of atan2 followed by sin and cos. The batch uses
+//rsqrt refined by one Newton step, within about 1e-6 relative of the exact square root of the reference.
+//An entity sitting on the target heads along +x, as atan2(0, 0) did.
+void steer_towards(sf::Vector2f target, const float* speeds, const unsigned char* kind, float delta, float* x, float* y, float* prev_x, float* prev_y, size_t n);
+void steer_towards_scalar(sf::Vector2f target, const float* speeds, const unsigned char* kind, float delta, float* x, float* y, float* prev_x, float* prev_y, size_t n);
@@ -0,0 +1,58 @@
+#include "profiler.hpp"
+
+#ifndef _WIN32
+    #include <fstream>
+#endif
+
+Profiler::Profiler(size_t capacity):
+    capacity(capacity),
+    dropped(0),
+    origin(std::chrono::steady_clock::now()){
+        events.reserve(capacity);
+}
+
+std::int64_t Profiler::now() const{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - origin).count();
+}
+
+void Profiler::record(const char* name, std::int64_t start, std::int64_t end){
+    if(events.size() >= capacity){
+        dropped++;
+        return;
+    }
+    events.push_back({name, start, end - start});
+}
+
+//Scope names are string literals, so they are written without escaping.
+bool Profiler::write_chrome_trace(const std::string& path) const{
+    std::ofstream file(path, std::ios::out | std::ios::trunc);
+    if(!file)
+        return false;
+
+    file << "{\"traceEvents\":[";
+    for(size_t i = 0; i < events.size(); i++){
+        const Profile_Event& e = events[i];
+        file << (i ? ",\n" : "\n")
+             << "{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"ts\":" << e.start << ",\"dur\":" << e.duration << ",\"pid\":1,\"tid\":1}";
+    }
+    file << "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped\":" << dropped << "}}\n";
+    return bool(file);
+}
+
+void Profiler::clear(){
+    events.clear();
+    dropped = 0;
+}
+
+Profiler& profiler(){
+    static Profiler instance(1 << 20);
+    return instance;
+}
+
+Profile_Scope::Profile_Scope(const char* name):
+    name(name),
+    start(profiler().now()){}
+
+Profile_Scope::~Profile_Scope(){
+    profiler().record(name, start, profiler().now());
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#ifndef _WIN32
+    #include <chrono>
+    #include <cstddef>
+    #include <cstdint>
+    #include <string>
+    #include <vector>
+#endif
+
+//Scoped timers recorded as complete events of a Chrome trace, readable in chrome://tracing or ui.perfetto.dev.
+//PROFILE_SCOPE compiles to nothing unless DASHER_PROFILE is defined (cmake -DDASHER_PROFILE=ON).
+struct Profile_Event{
+    const char* name;
+    std::int64_t start;
+    std::int64_t duration;
+};
+
+//Times are in microseconds since the profiler was created. Events past capacity are counted and dropped
+//instead of growing the buffer in the middle of a frame.
+struct Profiler{
+    std::vector<Profile_Event> events;
+    size_t capacity;
+    unsigned long long dropped;
+    std::chrono::steady_clock::time_point origin;
+
+    Profiler(size_t capacity);
+
+    std::int64_t now() const;
+    void record(const char* name, std::int64_t start, std::int64_t end);
+    bool write_chrome_trace(const std::string& path) const;
+    void clear();
+};
+
+Profiler& profiler();
+
+struct Profile_Scope{
+    const char* name;
+    std::int64_t start;
+
+    Profile_Scope(const char* name);
+    ~Profile_Scope();
+};
+
+#ifdef DASHER_PROFILE
+    #define PROFILE_CONCAT_(a, b) a##b
+    #define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+    #define PROFILE_SCOPE(name) Profile_Scope PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+#else
+    #define PROFILE_SCOPE(name)
+#endif
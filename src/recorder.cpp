@@ -0,0 +1,108 @@
+#include "recorder.hpp"
+
+#ifndef _WIN32
+    #include <fstream>
+    #include <iostream>
+#endif
+
+const char* record_name(Record_Kind kind){
+    switch(kind){
+        case Record_Kind::Frame:
+            return "frame";
+        case Record_Kind::Display:
+            return "display";
+        case Record_Kind::Spawn:
+            return "spawn";
+        case Record_Kind::Kill:
+            return "kill";
+        case Record_Kind::Pickup:
+            return "pickup";
+        case Record_Kind::Hit:
+            return "hit";
+        case Record_Kind::Dash_Start:
+            return "dash start";
+        case Record_Kind::Dash_Release:
+            return "dash release";
+        case Record_Kind::Game_Over:
+            return "game over";
+        case Record_Kind::Restart:
+            return "restart";
+    }
+    return "unknown";
+}
+
+Flight_Recorder::Flight_Recorder(std::size_t capacity, float budget, float window, float post_window, const std::string& prefix):
+    mask(0),
+    head(0),
+    budget(budget),
+    window(window),
+    post_window(post_window),
+    prefix(prefix),
+    dumps(0),
+    spike(-1),
+    last_dump(-1),
+    origin(std::chrono::steady_clock::now()){
+        std::size_t size = 1;
+        while(size < capacity)
+            size *= 2;
+        ring.resize(size);
+        mask = size - 1;
+}
+
+std::int64_t Flight_Recorder::now() const{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - origin).count();
+}
+
+void Flight_Recorder::record(Record_Kind kind, float value){
+    std::uint64_t h = head.load(std::memory_order_relaxed);
+    ring[h & mask] = {now(), value, kind};
+    head.store(h + 1, std::memory_order_release);
+}
+
+//work is the time spent on events, simulation and drawing. display is the time window.display() blocked,
+//which includes the wait for vertical sync, so it is recorded but not held against the budget.
+void Flight_Recorder::end_frame(float work, float display){
+    std::int64_t end = now();
+    std::int64_t work_us = work * 1e6f, display_us = display * 1e6f;
+    std::uint64_t h = head.load(std::memory_order_relaxed);
+    ring[h & mask] = {end - display_us - work_us, (float)work_us, Record_Kind::Frame};
+    ring[(h + 1) & mask] = {end - display_us, (float)display_us, Record_Kind::Display};
+    head.store(h + 2, std::memory_order_release);
+
+    //One dump per window at most, so a run of slow frames does not turn into a run of file writes.
+    if(spike < 0 && work > budget && (last_dump < 0 || end - last_dump > window * 1e6f))
+        spike = end;
+    if(spike >= 0 && end - spike >= post_window * 1e6f){
+        dump(spike - (std::int64_t)(window * 1e6f));
+        last_dump = end;
+        spike = -1;
+    }
+}
+
+bool Flight_Recorder::dump(std::int64_t from){
+    std::string path = prefix + "_" + std::to_string(dumps++) + ".json";
+    std::ofstream file(path, std::ios::out | std::ios::trunc);
+    if(!file){
+        std::cerr << "could not write " << path << std::endl;
+        return false;
+    }
+
+    std::uint64_t h = head.load(std::memory_order_acquire);
+    std::uint64_t first = h > ring.size() ? h - ring.size() : 0;
+    bool comma = false;
+    file << "{\"traceEvents\":[";
+    for(std::uint64_t i = first; i < h; i++){
+        const Record& r = ring[i & mask];
+        if(r.time < from) continue;
+
+        file << (comma ? ",\n" : "\n") << "{\"name\":\"" << record_name(r.kind) << "\",\"ts\":" << r.time << ",\"pid\":1,\"tid\":1,";
+        if(r.kind == Record_Kind::Frame || r.kind == Record_Kind::Display)
+            file << "\"ph\":\"X\",\"dur\":" << (std::int64_t)r.value << "}";
+        else
+            file << "\"ph\":\"i\",\"s\":\"g\",\"args\":{\"value\":" << r.value << "}}";
+        comma = true;
+    }
+    file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    std::cout << "frame over budget, flight recorder written to " << path << std::endl;
+    return bool(file);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#ifndef _WIN32
+    #include <atomic>
+    #include <chrono>
+    #include <cstddef>
+    #include <cstdint>
+    #include <string>
+    #include <vector>
+#endif
+
+enum class Record_Kind: std::uint8_t{
+    Frame,
+    Display,
+    Spawn,
+    Kill,
+    Pickup,
+    Hit,
+    Dash_Start,
+    Dash_Release,
+    Game_Over,
+    Restart
+};
+
+const char* record_name(Record_Kind kind);
+
+//time is in microseconds since the recorder was created. value is a duration in microseconds
+//for Frame and Display, a count for Kill and Pickup, unused otherwise.
+struct Record{
+    std::int64_t time;
+    float value;
+    Record_Kind kind;
+};
+
+//Always on: the last records live in a fixed power of two ring that a single writer fills without locking,
+//publishing each slot by advancing head. When a frame's work takes longer than budget, recording goes on
+//for post_window seconds, then the records of the window around the spike are written as a Chrome trace.
+struct Flight_Recorder{
+    std::vector<Record> ring;
+    std::size_t mask;
+    std::atomic<std::uint64_t> head;
+    float budget;
+    float window;
+    float post_window;
+    std::string prefix;
+    unsigned dumps;
+    std::int64_t spike;
+    std::int64_t last_dump;
+    std::chrono::steady_clock::time_point origin;
+
+    Flight_Recorder(std::size_t capacity, float budget, float window, float post_window, const std::string& prefix);
+
+    std::int64_t now() const;
+    void record(Record_Kind kind, float value = 0);
+    void end_frame(float work, float display);
+    bool dump(std::int64_t from);
+};
@@ -0,0 +1,332 @@
+#include "spatial.hpp"
+
+#ifndef _WIN32
+    #include <cmath>
+    #include <algorithm>
+#endif
+
+Spatial_Grid::Spatial_Grid(float cell_size):
+    cell_size(cell_size),
+    mask(0){}
+
+int Spatial_Grid::cell(float coordinate) const{
+    return (int)std::floor(coordinate / cell_size);
+}
+
+unsigned Spatial_Grid::bucket(int cx, int cy) const{
+    return ((unsigned)cx * 73856093u ^ (unsigned)cy * 19349663u) & mask;
+}
+
+//Keeps about one bucket per entity so buckets stay short whatever the horde size is.
+void Spatial_Grid::resize(size_t n){
+    size_t buckets = 64;
+    while(buckets < n)
+        buckets *= 2;
+    mask = buckets - 1;
+    start.assign(buckets + 1, 0);
+    items.resize(n);
+    bucket_of.resize(n);
+}
+
+void Spatial_Grid::reserve(size_t n){
+    size_t buckets = 64;
+    while(buckets < n)
+        buckets *= 2;
+    start.reserve(buckets + 1);
+    items.reserve(n);
+    bucket_of.reserve(n);
+}
+
+void Spatial_Grid::query(sf::Vector2f center, float radius, std::vector<unsigned>& out) const{
+    if(items.empty()) return;
+
+    int x0 = cell(center.x - radius), x1 = cell(center.x + radius);
+    int y0 = cell(center.y - radius), y1 = cell(center.y + radius);
+
+    //Different cells can hash to the same bucket: remember the ones already visited so nothing is reported twice.
+    //A query wider than that bookkeeping allows just reports everything.
+    const int max_visited = 16;
+    if((x1 - x0 + 1) * (y1 - y0 + 1) > max_visited){
+        out.insert(out.end(), items.begin(), items.end());
+        return;
+    }
+
+    unsigned visited[max_visited];
+    int n_visited = 0;
+    for(int cy = y0; cy <= y1; cy++)
+        for(int cx = x0; cx <= x1; cx++){
+            unsigned b = bucket(cx, cy);
+            bool seen = false;
+            for(int v = 0; v < n_visited && !seen; v++)
+                seen = visited[v] == b;
+            if(seen) continue;
+            visited[n_visited++] = b;
+
+            for(unsigned k = start[b]; k < start[b + 1]; k++)
+                out.push_back(items[k]);
+        }
+}
+
+Aabb aabb_union(const Aabb& a, const Aabb& b){
+    return {{std::min(a.min.x, b.min.x), std::min(a.min.y, b.min.y)},
+            {std::max(a.max.x, b.max.x), std::max(a.max.y, b.max.y)}};
+}
+
+float aabb_perimeter(const Aabb& box){
+    return 2 * ((box.max.x - box.min.x) + (box.max.y - box.min.y));
+}
+
+bool aabb_contains(const Aabb& outer, const Aabb& inner){
+    return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y &&
+           inner.max.x <= outer.max.x && inner.max.y <= outer.max.y;
+}
+
+//Slab test: clips the segment parameter range against both axes in turn.
+bool segment_hits_aabb(sf::Vector2f a, sf::Vector2f b, const Aabb& box){
+    float t_min = 0, t_max = 1;
+    float origin[2] = {a.x, a.y};
+    float direction[2] = {b.x - a.x, b.y - a.y};
+    float low[2] = {box.min.x, box.min.y};
+    float high[2] = {box.max.x, box.max.y};
+    for(int axis = 0; axis < 2; axis++){
+        if(direction[axis] == 0){
+            if(origin[axis] < low[axis] || origin[axis] > high[axis])
+                return false;
+            continue;
+        }
+        float inverse = 1 / direction[axis];
+        float t1 = (low[axis] - origin[axis]) * inverse;
+        float t2 = (high[axis] - origin[axis]) * inverse;
+        if(t1 > t2)
+            std::swap(t1, t2);
+        t_min = std::max(t_min, t1);
+        t_max = std::min(t_max, t2);
+        if(t_min > t_max)
+            return false;
+    }
+    return true;
+}
+
+Aabb_Tree::Aabb_Tree(float margin):
+    root(-1),
+    free_list(-1),
+    margin(margin){}
+
+bool Aabb_Tree::is_leaf(int node) const{
+    return nodes[node].left == -1;
+}
+
+int Aabb_Tree::allocate(){
+    int node;
+    if(free_list != -1){
+        node = free_list;
+        free_list = nodes[node].parent;
+    }
+    else{
+        node = nodes.size();
+        nodes.emplace_back();
+    }
+    nodes[node].parent = -1;
+    nodes[node].left = -1;
+    nodes[node].right = -1;
+    nodes[node].height = 0;
+    nodes[node].data = 0;
+    return node;
+}
+
+void Aabb_Tree::release(int node){
+    nodes[node].parent = free_list;
+    nodes[node].height = -1;
+    free_list = node;
+}
+
+int Aabb_Tree::create(const Aabb& box, unsigned data){
+    int leaf = allocate();
+    nodes[leaf].box = {{box.min.x - margin, box.min.y - margin}, {box.max.x + margin, box.max.y + margin}};
+    nodes[leaf].data = data;
+    insert_leaf(leaf);
+    return leaf;
+}
+
+void Aabb_Tree::destroy(int proxy){
+    remove_leaf(proxy);
+    release(proxy);
+}
+
+//Returns true when the leaf had to be reinserted.
+bool Aabb_Tree::move(int proxy, const Aabb& box, sf::Vector2f displacement){
+    if(aabb_contains(nodes[proxy].box, box))
+        return false;
+
+    Aabb fat = {{box.min.x - margin, box.min.y - margin}, {box.max.x + margin, box.max.y + margin}};
+    if(displacement.x < 0) fat.min.x += displacement.x;
+    else fat.max.x += displacement.x;
+    if(displacement.y < 0) fat.min.y += displacement.y;
+    else fat.max.y += displacement.y;
+
+    remove_leaf(proxy);
+    nodes[proxy].box = fat;
+    insert_leaf(proxy);
+    return true;
+}
+
+void Aabb_Tree::clear(){
+    nodes.clear();
+    root = -1;
+    free_list = -1;
+}
+
+//A tree of n leaves has n - 1 inner nodes; the traversal stack stays around twice the height.
+void Aabb_Tree::reserve(size_t leaves){
+    nodes.reserve(2 * leaves);
+    stack.reserve(64);
+}
+
+//Walks down picking whichever child grows the least in perimeter, then balances on the way back up.
+void Aabb_Tree::insert_leaf(int leaf){
+    if(root == -1){
+        root = leaf;
+        nodes[leaf].parent = -1;
+        return;
+    }
+
+    const Aabb box = nodes[leaf].box;
+    int sibling = root;
+    while(!is_leaf(sibling)){
+        const Node& node = nodes[sibling];
+        float combined = aabb_perimeter(aabb_union(node.box, box));
+        float cost = 2 * combined;
+        float inheritance = 2 * (combined - aabb_perimeter(node.box));
+
+        float child_cost[2];
+        int children[2] = {node.left, node.right};
+        for(int c = 0; c < 2; c++){
+            const Node& child = nodes[children[c]];
+            child_cost[c] = aabb_perimeter(aabb_union(child.box, box)) + inheritance;
+            if(!is_leaf(children[c]))
+                child_cost[c] -= aabb_perimeter(child.box);
+        }
+
+        if(cost < child_cost[0] && cost < child_cost[1])
+            break;
+        sibling = child_cost[0] < child_cost[1] ? node.left : node.right;
+    }
+
+    int old_parent = nodes[sibling].parent;
+    int new_parent = allocate();
+    nodes[new_parent].parent = old_parent;
+    nodes[new_parent].box = aabb_union(box, nodes[sibling].box);
+    nodes[new_parent].height = nodes[sibling].height + 1;
+    nodes[new_parent].left = sibling;
+    nodes[new_parent].right = leaf;
+    nodes[sibling].parent = new_parent;
+    nodes[leaf].parent = new_parent;
+
+    if(old_parent == -1)
+        root = new_parent;
+    else if(nodes[old_parent].left == sibling)
+        nodes[old_parent].left = new_parent;
+    else
+        nodes[old_parent].right = new_parent;
+
+    refit(nodes[leaf].parent);
+}
+
+void Aabb_Tree::remove_leaf(int leaf){
+    if(leaf == root){
+        root = -1;
+        return;
+    }
+
+    int parent = nodes[leaf].parent;
+    int grand_parent = nodes[parent].parent;
+    int sibling = nodes[parent].left == leaf ? nodes[parent].right : nodes[parent].left;
+    release(parent);
+
+    if(grand_parent == -1){
+        root = sibling;
+        nodes[sibling].parent = -1;
+        return;
+    }
+
+    if(nodes[grand_parent].left == parent)
+        nodes[grand_parent].left = sibling;
+    else
+        nodes[grand_parent].right = sibling;
+    nodes[sibling].parent = grand_parent;
+    refit(grand_parent);
+}
+
+void Aabb_Tree::refit(int node){
+    while(node != -1){
+        node = balance(node);
+        Node& n = nodes[node];
+        n.height = 1 + std::max(nodes[n.left].height, nodes[n.right].height);
+        n.box = aabb_union(nodes[n.left].box, nodes[n.right].box);
+        node = n.parent;
+    }
+}
+
+//If one subtree of a is two levels taller than the other, its root takes the place of a and a adopts
+//the shorter of its grandchildren. Returns the node now sitting where a was.
+int Aabb_Tree::balance(int a){
+    if(is_leaf(a) || nodes[a].height < 2)
+        return a;
+
+    int b = nodes[a].left;
+    int c = nodes[a].right;
+    int skew = nodes[c].height - nodes[b].height;
+    if(skew >= -1 && skew <= 1)
+        return a;
+
+    //up is the child taking a's place, other is a's remaining child.
+    int up = skew > 1 ? c : b;
+    int other = skew > 1 ? b : c;
+    int f = nodes[up].left;
+    int g = nodes[up].right;
+
+    nodes[up].parent = nodes[a].parent;
+    nodes[a].parent = up;
+    if(nodes[up].parent == -1)
+        root = up;
+    else if(nodes[nodes[up].parent].left == a)
+        nodes[nodes[up].parent].left = up;
+    else
+        nodes[nodes[up].parent].right = up;
+
+    //The taller grandchild stays under up, the other one moves under a in up's old slot.
+    int keep = nodes[f].height > nodes[g].height ? f : g;
+    int give = keep == f ? g : f;
+    nodes[up].left = a;
+    nodes[up].right = keep;
+    if(skew > 1)
+        nodes[a].right = give;
+    else
+        nodes[a].left = give;
+    nodes[give].parent = a;
+
+    nodes[a].box = aabb_union(nodes[other].box, nodes[give].box);
+    nodes[a].height = 1 + std::max(nodes[other].height, nodes[give].height);
+    nodes[up].box = aabb_union(nodes[a].box, nodes[keep].box);
+    nodes[up].height = 1 + std::max(nodes[a].height, nodes[keep].height);
+    return up;
+}
+
+void Aabb_Tree::query_segment(sf::Vector2f a, sf::Vector2f b, std::vector<unsigned>& out) const{
+    if(root == -1) return;
+
+    stack.clear();
+    stack.push_back(root);
+    while(!stack.empty()){
+        int node = stack.back();
+        stack.pop_back();
+        if(!segment_hits_aabb(a, b, nodes[node].box))
+            continue;
+        if(is_leaf(node))
+            out.push_back(nodes[node].data);
+        else{
+            stack.push_back(nodes[node].left);
+            stack.push_back(nodes[node].right);
+        }
+    }
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <SFML/System/Vector2.hpp>
+
+#ifndef _WIN32
+    #include <cstddef>
+    #include <vector>
+#endif
+
+//Uniform grid hashed into a power of two bucket table, rebuilt from scratch every tick with a counting sort.
+//A query returns every index stored in the buckets its cells fall into: hash collisions can add far away
+//entities, so callers still run their exact distance test on the result.
+struct Spatial_Grid{
+    float cell_size;
+    unsigned mask;
+    std::vector<unsigned> start;
+    std::vector<unsigned> items;
+    std::vector<unsigned> bucket_of;
+
+    Spatial_Grid(float cell_size);
+
+    template <typename Position>
+    void build(size_t n, Position position);
+    void query(sf::Vector2f center, float radius, std::vector<unsigned>& out) const;
+
+    int cell(float coordinate) const;
+    unsigned bucket(int cx, int cy) const;
+    void resize(size_t n);
+    void reserve(size_t n);
+};
+
+template <typename Position>
+void Spatial_Grid::build(size_t n, Position position){
+    resize(n);
+    for(size_t i = 0; i < n; i++){
+        sf::Vector2f p = position(i);
+        bucket_of[i] = bucket(cell(p.x), cell(p.y));
+        start[bucket_of[i] + 1]++;
+    }
+    for(size_t b = 1; b < start.size(); b++)
+        start[b] += start[b - 1];
+
+    //start[b] is used as the fill cursor of bucket b and ends up as the start of bucket b + 1, then shifted back.
+    for(size_t i = 0; i < n; i++)
+        items[start[bucket_of[i]]++] = i;
+    for(size_t b = start.size() - 1; b > 0; b--)
+        start[b] = start[b - 1];
+    start[0] = 0;
+}
+
+struct Aabb{
+    sf::Vector2f min;
+    sf::Vector2f max;
+};
+
+Aabb aabb_union(const Aabb& a, const Aabb& b);
+float aabb_perimeter(const Aabb& box);
+bool aabb_contains(const Aabb& outer, const Aabb& inner);
+bool segment_hits_aabb(sf::Vector2f a, sf::Vector2f b, const Aabb& box);
+
+//Dynamic bounding volume tree kept balanced with rotations as leaves come and go.
+//Leaves store a fattened box, stretched along the displacement, so a moving entity only gets reinserted
+//once it leaves it. Queries test the fat boxes: callers still run their exact test on the result.
+struct Aabb_Tree{
+    struct Node{
+        Aabb box;
+        int parent;     //next free node while the node is on the free list
+        int left;       //-1 on leaves
+        int right;
+        int height;     //0 on leaves, -1 on free nodes
+        unsigned data;
+    };
+
+    std::vector<Node> nodes;
+    int root;
+    int free_list;
+    float margin;
+    mutable std::vector<int> stack;
+
+    Aabb_Tree(float margin);
+
+    int create(const Aabb& box, unsigned data);
+    void destroy(int proxy);
+    bool move(int proxy, const Aabb& box, sf::Vector2f displacement);
+    void clear();
+    void reserve(size_t leaves);
+    void query_segment(sf::Vector2f a, sf::Vector2f b, std::vector<unsigned>& out) const;
+
+    bool is_leaf(int node) const;
+    int allocate();
+    void release(int node);
+    void insert_leaf(int leaf);
+    void remove_leaf(int leaf);
+    void refit(int node);
+    int balance(int node);
+};
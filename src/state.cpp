@@ -0,0 +1,277 @@
+#include "state.hpp"
+#include "defaults.hpp"
+#include "profiler.hpp"
+#include "alloc.hpp"
+#include "animation.hpp"
+
+#ifndef _WIN32
+    #include <string>
+#endif
+
+State::State(std::uint64_t seed):
+    player_texture(player_sheet),
+    ghost_texture(ghost_sheet),
+    heart_texture(heart_sprite),
+    heart_sheet_texture(animated_heart),
+    backgournd_texture(background),
+    gameover_texture(gameover_path),
+    player_sprite(player_texture),
+    aftr_sprite(player_texture),
+    gameover(gameover_texture),
+    ghost_batch(ghost_texture),
+    heart_batch(heart_sheet_texture),
+    border_batch(backgournd_texture),
+    border_buffer(sf::PrimitiveType::Triangles, sf::VertexBuffer::Usage::Static),
+    score_font(font_path),
+    hud(score_font, heart_texture),
+    player_hit_buffer(player_hit_path),
+    player_hit_sound(player_hit_buffer),
+    hit_buffer(hit_path),
+    hit_sound(hit_buffer),
+    pickup_buffer(pick_path),
+    pickup_sound(pickup_buffer),
+    jobs(default_workers()),
+    sim(seed),
+    score_file("score.txt", std::ios::in | std::ios::app),
+    ost(ost_path),
+    defeat_ost(defeat_path),
+    recorder(flight_capacity, frame_budget, flight_window, flight_post_window, flight_prefix),
+    was_dashing(false){
+        sim.horde.jobs = &jobs;
+        player_sprite.setOrigin(sim.player.origin);
+        player_sprite.setScale(sim.player.scale);
+        aftr_sprite.setOrigin(sim.player.origin);
+        aftr_sprite.setScale(sim.player.scale);
+        //aftr_sprite.setColor(sf::Color(127, 127, 127));
+
+        gameover.setScale(player_scale);
+        gameover.setOrigin(sf::Vector2f(200, 64));
+        gameover.setPosition(sf::Vector2f(window_width / 2, window_height / 2));
+
+        //The dash line and the fail bar are kept and only moved or resized each frame, so drawing them does not allocate.
+        dash_line.setFillColor(sf::Color::White);
+        dash_line.setOrigin({0, sim.player.scale.x / 2});
+        fail_back.setSize({150, 20});
+        fail_back.setOrigin({75,0});
+        fail_back.setFillColor(sf::Color::Black);
+        fail_back.setOutlineThickness(-5);
+        fail_back.setOutlineColor(sf::Color::White);
+        fail_fill.setOrigin({75,0});
+        fail_fill.setFillColor(sf::Color::White);
+        build_background();
+
+        player_hit_sound.setVolume(volume);
+        hit_sound.setVolume(volume);
+        pickup_sound.setVolume(volume);
+
+        std::string line;
+        if(std::getline(score_file, line))
+            try{
+                high_score = stoull(line);
+            }
+            catch(...){
+                high_score = 0;
+            }
+        else
+            high_score = 0;
+        hud.set_high_score(high_score);
+
+        score_file.close();
+        ost.setLooping(true);
+        ost.setVolume(volume);
+        ost.play();
+        defeat_ost.setLooping(true);
+        defeat_ost.setVolume(volume);
+}
+
+bool State::update(float delta){
+    PROFILE_SCOPE("State::update");
+    ALLOC_SCOPE("State::update");
+    if(sim.game_over)   return true;
+    if(sim.update(delta)){
+        recorder.record(Record_Kind::Game_Over);
+        if(sim.horde.score > high_score){
+            high_score = sim.horde.score;
+            hud.set_high_score(high_score);
+            score_file.open("score.txt", std::ios::out | std::ios::trunc);
+            score_file << high_score;
+            score_file.flush();
+            score_file.close();
+
+        }
+        ost.stop();
+        defeat_ost.play();
+        return true;
+    }
+
+    record_events();
+    if(sim.player.hurt)
+        player_hit_sound.play();
+    if(sim.horde.kills)
+        hit_sound.play();
+    if(sim.horde.pickups)
+        pickup_sound.play();
+    return false;
+}
+
+//Dashes are started from the input handlers between ticks, so a new one is noticed on the next tick.
+void State::record_events(){
+    Player& player = sim.player;
+    if(player.dashing && !was_dashing)
+        recorder.record(Record_Kind::Dash_Start);
+    was_dashing = player.dashing;
+    if(player.attack)
+        recorder.record(Record_Kind::Dash_Release);
+    if(player.hurt)
+        recorder.record(Record_Kind::Hit);
+    if(sim.horde.spawns)
+        recorder.record(Record_Kind::Spawn, sim.horde.spawns);
+    if(sim.horde.kills)
+        recorder.record(Record_Kind::Kill, sim.horde.kills);
+    if(sim.horde.pickups)
+        recorder.record(Record_Kind::Pickup, sim.horde.pickups);
+}
+
+//alpha is how far the display is between the previous and the current simulation step.
+void State::draw(sf::RenderWindow& window, float alpha){
+    PROFILE_SCOPE("State::draw");
+    ALLOC_SCOPE("State::draw");
+    hud.set_score(sim.horde.score);
+    hud.set_health(sim.player.health);
+
+    draw_horde(window, alpha);
+    draw_player(window, alpha);
+    if(!sim.game_over){
+        draw_background(window);
+        hud.draw(window);
+    }
+    else
+        draw_gameover(window);
+}
+
+void State::draw_player(sf::RenderWindow& window, float alpha){
+    Player& player = sim.player;
+    sf::Vector2f position = lerp(player.prev_position, player.position, alpha);
+    if(player.dashing){
+        draw_line(window, position);
+        aftr_sprite.setTextureRect(player.aftr.rect);
+        aftr_sprite.setPosition(player.aftr.position);
+        window.draw(aftr_sprite);
+    }
+
+    if(player.fail && !player.dead)
+        draw_fail_bar(window, position);
+
+    player_sprite.setColor((player.invulnerable && !player.dead) ? sf::Color::Red : sf::Color::White);
+    player_sprite.setRotation(sf::degrees(player.dead ? 90 : 0));
+    player_sprite.setPosition(position);
+    player_sprite.setTextureRect(player.sprite_rect());
+    window.draw(player_sprite);
+}
+
+void State::draw_line(sf::RenderWindow& window, sf::Vector2f position){
+    Player& player = sim.player;
+    dash_line.setSize({dist(position, player.aftr.position), player.scale.x});
+    dash_line.setPosition(position);
+    dash_line.setRotation(angle(position, player.aftr.position));
+    window.draw(dash_line);
+}
+
+void State::draw_fail_bar(sf::RenderWindow& window, sf::Vector2f position){
+    Player& player = sim.player;
+    fail_back.setPosition(position + sf::Vector2f(0, 100));
+    window.draw(fail_back);
+
+    fail_fill.setSize({(150 * player.fail_progress()), 20});
+    fail_fill.setPosition(position + sf::Vector2f(0, 100));
+    window.draw(fail_fill);
+}
+
+//One draw call for all the hearts and one for all the ghosts, whatever the size of the horde.
+//Frames are looked up from the shared clock, nothing is advanced per entity.
+void State::draw_horde(sf::RenderWindow& window, float alpha){
+    float now = sim.timers.time();
+    heart_batch.clear();
+    sf::Vector2f heart_origin(heart_sprite_size.x / 2, heart_sprite_size.y / 2);
+    Heart_Table& hearts = sim.horde.hearts;
+    for(size_t i = 0; i < hearts.size(); i++){
+        unsigned frame = animation_frame(now, hearts.column<Animation_Start>()[i], animation_fps_period, h_sheet);
+        heart_batch.add(position_of(hearts, i), heart_origin, player_scale, heart_frames(0, frame));
+    }
+    heart_batch.draw(window);
+
+    ghost_batch.clear();
+    Ghost_Table& ghosts = sim.horde.ghosts;
+    for(size_t i = 0; i < ghosts.size(); i++){
+        const Ghost_Archetype& archetype = ghost_archetypes[ghosts.column<Kind>()[i]];
+        unsigned frame = animation_frame(now, ghosts.column<Animation_Start>()[i], archetype.frame_period, archetype.frames);
+        ghost_batch.add(position_of(ghosts, i, alpha), archetype.origin, archetype.scale, archetype.frame_rects[frame]);
+    }
+    ghost_batch.draw(window);
+}
+
+//The border never changes: its tiles are laid out once and uploaded to the GPU when vertex buffers are available.
+void State::build_background(){
+    sf::Vector2i size(32, 32);
+    sf::Vector2f scale(player_scale.x / 2, player_scale.y / 2);
+    for(size_t j = 0; j < 9 ; j++){
+        for(size_t i = 0; i < 16; i++){
+            sf::IntRect rect;
+            switch(j){
+                case 0:
+                    rect = sf::IntRect(sf::Vector2i(32, 32), size);
+                    break;
+                case 1:
+                    if(i == 0)
+                        rect = sf::IntRect(sf::Vector2i(0, 0), size);
+                    else if(i == 15)
+                        rect = sf::IntRect(sf::Vector2i(96, 0), size);
+                    else
+                        rect = sf::IntRect(sf::Vector2i(32, 0), size);
+                    break;
+                case 8:
+                    if(i == 0)
+                        rect = sf::IntRect(sf::Vector2i(0, 96), size);
+                    else if(i == 15)
+                        rect = sf::IntRect(sf::Vector2i(96, 96), size);
+                    else
+                        rect = sf::IntRect(sf::Vector2i(32, 96), size);
+                    break;
+                default:
+                    if(i == 0)
+                        rect = sf::IntRect(sf::Vector2i(0, 32), size);
+                    else if(i == 15)
+                        rect = sf::IntRect(sf::Vector2i(96, 32), size);
+                    else
+                        continue;
+                    break;
+            }
+
+            border_batch.add(sf::Vector2f(i * 80, j * 80), sf::Vector2f(0, 0), scale, rect);
+        }
+    }
+
+    const sf::VertexArray& vertices = border_batch.vertices;
+    if(!sf::VertexBuffer::isAvailable() || !border_buffer.create(vertices.getVertexCount()) || !border_buffer.update(&vertices[0]))
+        border_buffer = sf::VertexBuffer();
+}
+
+void State::draw_background(sf::RenderWindow& window){
+    if(border_buffer.getVertexCount())
+        window.draw(border_buffer, sf::RenderStates(&backgournd_texture));
+    else
+        border_batch.draw(window);
+}
+
+void State::restart(){
+    if(!sim.game_over)  return;
+    recorder.record(Record_Kind::Restart);
+    sim.restart();
+    defeat_ost.stop();
+    ost.play();
+}
+
+void State::draw_gameover(sf::RenderWindow& window){
+    window.draw(gameover);
+    hud.draw_results(window);
+}
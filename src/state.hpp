@@ -0,0 +1,60 @@
+#pragma once
+
+#include "entities.hpp"
+#include "batch.hpp"
+#include "hud.hpp"
+#include "recorder.hpp"
+#include <SFML/Graphics.hpp>
+#include <SFML/Audio.hpp>
+#include <fstream>
+
+//Presentation of a Simulation: textures, sounds, music and the high score file live here.
+struct State{
+    sf::Texture player_texture;
+    sf::Texture ghost_texture;
+    sf::Texture heart_texture;
+    sf::Texture heart_sheet_texture;
+    sf::Texture backgournd_texture;
+    sf::Texture gameover_texture;
+    sf::Sprite player_sprite;
+    sf::Sprite aftr_sprite;
+    sf::Sprite gameover;
+    sf::RectangleShape dash_line;
+    sf::RectangleShape fail_back;
+    sf::RectangleShape fail_fill;
+    Sprite_Batch ghost_batch;
+    Sprite_Batch heart_batch;
+    Sprite_Batch border_batch;
+    sf::VertexBuffer border_buffer;
+    sf::Font score_font;
+    Hud hud;
+    sf::SoundBuffer player_hit_buffer;
+    sf::Sound player_hit_sound;
+    sf::SoundBuffer hit_buffer;
+    sf::Sound hit_sound;
+    sf::SoundBuffer pickup_buffer;
+    sf::Sound pickup_sound;
+    Job_System jobs;
+    Simulation sim;
+    std::fstream score_file;
+    unsigned long long high_score;
+    sf::Music ost;
+    sf::Music defeat_ost;
+    Flight_Recorder recorder;
+    bool was_dashing;
+
+    State(std::uint64_t seed);
+
+    bool update(float delta);
+    void draw(sf::RenderWindow& window, float alpha);
+
+    void draw_player(sf::RenderWindow& window, float alpha);
+    void draw_line(sf::RenderWindow& window, sf::Vector2f position);
+    void draw_fail_bar(sf::RenderWindow& window, sf::Vector2f position);
+    void draw_horde(sf::RenderWindow& window, float alpha);
+    void build_background();
+    void draw_background(sf::RenderWindow& window);
+    void record_events();
+    void draw_gameover(sf::RenderWindow& window);
+    void restart();
+};
@@ -0,0 +1,134 @@
+#include "timers.hpp"
+
+#ifndef _WIN32
+    #include <algorithm>
+    #include <cmath>
+#endif
+
+static std::uint64_t microseconds(float seconds){
+    return seconds > 0 ? std::llround(seconds * 1e6) : 0;
+}
+
+//The millisecond a time in microseconds rounds to.
+static std::uint64_t millisecond(std::uint64_t time){
+    return (time + 500) / 1000;
+}
+
+Timer_Wheel::Timer_Wheel(size_t capacity):
+    nodes(capacity),
+    overflow(0){
+        fired.reserve(capacity);
+        clear();
+}
+
+void Timer_Wheel::clear(){
+    for(unsigned slot = 0; slot < n_levels * n_slots; slot++)
+        slots[slot] = -1;
+    free_list = -1;
+    for(int i = nodes.size() - 1; i >= 0; i--){
+        nodes[i].next = free_list;
+        free_list = i;
+    }
+    fired.clear();
+    now = 0;
+    tick = 0;
+}
+
+int Timer_Wheel::schedule(float seconds, Timer_Kind kind, unsigned data){
+    if(free_list == -1){
+        overflow++;
+        return -1;
+    }
+    int node = free_list;
+    free_list = nodes[node].next;
+    nodes[node].due = now + microseconds(seconds);
+    nodes[node].timer = {kind, data};
+    link(node, tick + 1);
+    return node;
+}
+
+void Timer_Wheel::cancel(int handle){
+    if(handle == -1) return;
+    unlink(handle);
+    nodes[handle].next = free_list;
+    free_list = handle;
+}
+
+//A deadline before earliest is placed at earliest: scheduling uses the next tick, since the current one has
+//already fired, while cascading uses the current tick, whose level 0 slot is about to fire.
+void Timer_Wheel::link(int node, std::uint64_t earliest){
+    std::uint64_t due = std::max(millisecond(nodes[node].due), earliest);
+    std::uint64_t span = due - tick;
+
+    unsigned level = 0;
+    while(level + 1 < n_levels && span >= std::uint64_t(1) << (slot_bits * (level + 1)))
+        level++;
+    std::uint64_t top = std::uint64_t(1) << (slot_bits * n_levels);
+    if(span >= top)
+        due = tick + top - 1;
+
+    nodes[node].slot = level * n_slots + ((due >> (slot_bits * level)) & (n_slots - 1));
+    int& head = slots[nodes[node].slot];
+    nodes[node].prev = -1;
+    nodes[node].next = head;
+    if(head != -1)
+        nodes[head].prev = node;
+    head = node;
+}
+
+void Timer_Wheel::unlink(int node){
+    Node& n = nodes[node];
+    if(n.next != -1)
+        nodes[n.next].prev = n.prev;
+    if(n.prev != -1)
+        nodes[n.prev].next = n.next;
+    else
+        slots[n.slot] = n.next;
+}
+
+//Empties the slot of level the wheel just reached and places its timers again, in finer levels.
+void Timer_Wheel::cascade(unsigned level){
+    int& head = slots[level * n_slots + ((tick >> (slot_bits * level)) & (n_slots - 1))];
+    int node = head;
+    head = -1;
+    while(node != -1){
+        int next = nodes[node].next;
+        link(node, tick);
+        node = next;
+    }
+}
+
+//fired holds the timers that came due during this advance, in the order they did.
+void Timer_Wheel::advance(float delta){
+    fired.clear();
+    now += microseconds(delta);
+    std::uint64_t target = millisecond(now);
+    while(tick < target){
+        tick++;
+        //Coarse levels first: what they hand down may land in the slot of a finer level reached at the same tick.
+        for(unsigned level = n_levels - 1; level > 0; level--)
+            if((tick & ((std::uint64_t(1) << (slot_bits * level)) - 1)) == 0)
+                cascade(level);
+
+        int& head = slots[tick & (n_slots - 1)];
+        int node = head;
+        head = -1;
+        while(node != -1){
+            int next = nodes[node].next;
+            fired.push_back(nodes[node].timer);
+            nodes[node].next = free_list;
+            free_list = node;
+            node = next;
+        }
+    }
+}
+
+float Timer_Wheel::remaining(int handle) const{
+    if(handle == -1 || nodes[handle].due <= now)
+        return 0;
+    return (nodes[handle].due - now) / 1e6f;
+}
+
+float Timer_Wheel::time() const{
+    return now / 1e6f;
+}
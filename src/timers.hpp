@@ -0,0 +1,60 @@
+#pragma once
+
+#ifndef _WIN32
+    #include <cstddef>
+    #include <cstdint>
+    #include <vector>
+#endif
+
+enum class Timer_Kind: std::uint8_t{
+    Invulnerability,
+    Dash_Fail,
+    Spawn
+};
+
+struct Timer{
+    Timer_Kind kind;
+    unsigned data;
+};
+
+//Hierarchical timing wheel: levels of 64 slots, each slot of a level spanning a whole turn of the level below,
+//starting from 1 ms slots. A timer sits in the coarsest level its deadline needs and moves down a level when
+//the wheel reaches its slot, so advancing costs a step per millisecond plus the timers that move or fire,
+//however many timers are waiting. Deadlines past the top level wait in its farthest slot and are placed again.
+//Time is simulation time in microseconds, rounded to the millisecond when timers are placed and fired.
+//Timers live in a fixed pool, scheduling past capacity is counted in overflow and returns -1.
+//A handle is only valid until its timer fires or is cancelled.
+struct Timer_Wheel{
+    static const unsigned slot_bits = 6;
+    static const unsigned n_slots = 1 << slot_bits;
+    static const unsigned n_levels = 4;
+
+    struct Node{
+        std::uint64_t due;  //microseconds
+        int prev;           //-1 at the head of a slot
+        int next;           //next free node while the node is on the free list
+        int slot;           //level * n_slots + slot
+        Timer timer;
+    };
+
+    std::vector<Node> nodes;
+    int free_list;
+    int slots[n_levels * n_slots];
+    std::uint64_t now;
+    std::uint64_t tick;
+    std::vector<Timer> fired;
+    unsigned long long overflow;
+
+    Timer_Wheel(size_t capacity);
+
+    int schedule(float seconds, Timer_Kind kind, unsigned data = 0);
+    void cancel(int handle);
+    void advance(float delta);
+    float remaining(int handle) const;
+    float time() const;
+    void clear();
+
+    void link(int node, std::uint64_t earliest);
+    void unlink(int node);
+    void cascade(unsigned level);
+};